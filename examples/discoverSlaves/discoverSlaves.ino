@@ -0,0 +1,154 @@
+/** =========================================================================
+ * @example{lineno} discoverSlaves.ino
+ * @author Sara Geleskie Damiano <sdamiano@stroudcenter.org>
+ * @copyright Stroud Water Research Center
+ * @license This example is published under the BSD-3 license.
+ *
+ * @brief This example finds every slave on a modbus bus and prints what each one
+ * reports about itself.
+ *
+ * @m_examplenavigation{example_discover_slaves,}
+ * @m_footernavigation
+ * ======================================================================= */
+
+// ---------------------------------------------------------------------------
+// Include the base required libraries
+// ---------------------------------------------------------------------------
+#include <Arduino.h>
+#include <SensorModbusMaster.h>
+
+// ==========================================================================
+//  Bus Settings
+// ==========================================================================
+
+// The Modbus baud rate the slaves use
+int32_t modbusBaudRate = 9600;
+
+// The range of slave addresses to probe
+byte firstAddress = 1;
+byte lastAddress  = 247;
+
+// The time in milliseconds to wait for each slave to answer a probe
+// At 9600 baud, 30ms is enough for most slaves; you can go lower at higher baud rates
+uint32_t probeTimeout = 30;
+
+
+// ==========================================================================
+//  Data Logger Options
+// ==========================================================================
+const int32_t serialBaud = 115200;  // Baud rate for serial monitor
+
+// Define pin number variables
+const int DEREPin = -1;  // The pin controlling Receive Enable and Driver Enable
+                         // on the RS485 adapter, if applicable (else, -1)
+                         // Setting HIGH enables the driver (arduino) to send text
+                         // Setting LOW enables the receiver (sensor) to send text
+
+// ==========================================================================
+// Create and Assign a Serial Port for Modbus
+// ==========================================================================
+#if defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_FEATHER328P)
+// The Uno only has 1 hardware serial port, which is dedicated to communication with the
+// computer. If using an Uno, you will be restricted to using AltSofSerial or
+// SoftwareSerial
+#include <SoftwareSerial.h>
+const int      SSRxPin = 10;  // Receive pin for software serial (Rx on RS485 adapter)
+const int      SSTxPin = 11;  // Send pin for software serial (Tx on RS485 adapter)
+#pragma message("Using Software Serial for the Uno on pins 10 and 11")
+SoftwareSerial modbusSerial(SSRxPin, SSTxPin);
+
+#elif defined(ESP8266)
+#include <SoftwareSerial.h>
+#pragma message("Using Software Serial for the ESP8266")
+SoftwareSerial modbusSerial;
+
+#elif defined(NRF52832_FEATHER) || defined(ARDUINO_NRF52840_FEATHER)
+#pragma message("Using TinyUSB for the NRF52")
+#include <Adafruit_TinyUSB.h>
+HardwareSerial& modbusSerial = Serial1;
+
+#elif !defined(NO_GLOBAL_SERIAL1) && !defined(STM32_CORE_VERSION)
+// This is just a assigning another name to the same port, for convenience
+// Unless it is unavailable, always prefer hardware serial.
+#pragma message("Using HardwareSerial / Serial1")
+HardwareSerial& modbusSerial = Serial1;
+
+#else
+// This is just a assigning another name to the same port, for convenience
+// Unless it is unavailable, always prefer hardware serial.
+#pragma message("Using HardwareSerial / Serial")
+HardwareSerial& modbusSerial = Serial;
+#endif
+
+// Construct the modbus instance
+modbusMaster modbus;
+
+
+// ==========================================================================
+// Working Functions
+// ==========================================================================
+// Print everything a slave told us about itself
+void printDevice(const modbusDeviceInfo& info) {
+    Serial.print(F("Slave "));
+    Serial.println(info.slaveID);
+    if (info.hasServerID) {
+        Serial.print(F("  Server ID:"));
+        for (byte i = 0; i < info.serverIDLength; i++) {
+            Serial.print(F(" 0x"));
+            if (info.serverID[i] < 0x10) { Serial.print('0'); }
+            Serial.print(info.serverID[i], HEX);
+        }
+        Serial.println();
+        Serial.print(F("  Running: "));
+        Serial.println(info.runIndicator ? F("yes") : F("no"));
+    }
+    if (info.hasIdentification) {
+        Serial.print(F("  Vendor: "));
+        Serial.println(info.vendorName);
+        Serial.print(F("  Product: "));
+        Serial.println(info.productCode);
+        Serial.print(F("  Revision: "));
+        Serial.println(info.revision);
+    }
+    if (!info.hasServerID && !info.hasIdentification) {
+        Serial.println(F("  The slave does not support identification"));
+    }
+}
+
+
+// ==========================================================================
+//  Arduino Setup Function
+// ==========================================================================
+void setup() {
+    if (DEREPin >= 0) { pinMode(DEREPin, OUTPUT); }
+
+    // Turn on the "main" serial port for debugging via USB Serial Monitor
+    Serial.begin(serialBaud);
+
+    // Turn on your modbus serial port
+    modbusSerial.begin(modbusBaudRate);
+
+    // Start the modbusMaster instance; the slave ID doesn't matter for discovery
+    modbus.begin(modbusSerial, DEREPin);
+    modbus.setDiscoveryTimeout(probeTimeout);
+
+    Serial.println(F("\nRunning the 'discoverSlaves()' example sketch."));
+    Serial.print(F("Probing slave addresses "));
+    Serial.print(firstAddress);
+    Serial.print(F(" to "));
+    Serial.println(lastAddress);
+
+    uint32_t start = millis();
+    uint8_t  found = modbus.discoverSlaves(firstAddress, lastAddress, printDevice);
+
+    Serial.print(F("\nFound "));
+    Serial.print(found);
+    Serial.print(F(" slaves in "));
+    Serial.print(millis() - start);
+    Serial.println(F(" ms"));
+}
+
+// ==========================================================================
+//  Arduino Loop Function
+// ==========================================================================
+void loop() {}
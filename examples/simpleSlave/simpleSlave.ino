@@ -0,0 +1,143 @@
+/** =========================================================================
+ * @example{lineno} simpleSlave.ino
+ * @author Sara Geleskie Damiano <sdamiano@stroudcenter.org>
+ * @copyright Stroud Water Research Center
+ * @license This example is published under the BSD-3 license.
+ *
+ * @brief This example acts as a modbus slave, serving data from tables in memory.
+ *
+ * @m_examplenavigation{example_simple_slave,}
+ * @m_footernavigation
+ * ======================================================================= */
+
+// ---------------------------------------------------------------------------
+// Include the base required libraries
+// ---------------------------------------------------------------------------
+#include <Arduino.h>
+#include <SensorModbusSlave.h>
+
+// ==========================================================================
+//  Slave Settings
+// ==========================================================================
+
+// The Modbus baud rate to use
+int32_t modbusBaudRate = 9600;
+
+// The slave ID to answer to
+byte slaveID = 0x01;
+
+
+// ==========================================================================
+//  Data Logger Options
+// ==========================================================================
+const int32_t serialBaud = 115200;  // Baud rate for serial monitor
+
+// Define pin number variables
+const int DEREPin = -1;  // The pin controlling Receive Enable and Driver Enable
+                         // on the RS485 adapter, if applicable (else, -1)
+                         // Setting HIGH enables the driver (arduino) to send text
+                         // Setting LOW enables the receiver (sensor) to send text
+
+// ==========================================================================
+// Create and Assign a Serial Port for Modbus
+// ==========================================================================
+#if defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_FEATHER328P)
+// The Uno only has 1 hardware serial port, which is dedicated to communication with the
+// computer. If using an Uno, you will be restricted to using AltSofSerial or
+// SoftwareSerial
+#include <SoftwareSerial.h>
+const int      SSRxPin = 10;  // Receive pin for software serial (Rx on RS485 adapter)
+const int      SSTxPin = 11;  // Send pin for software serial (Tx on RS485 adapter)
+#pragma message("Using Software Serial for the Uno on pins 10 and 11")
+SoftwareSerial modbusSerial(SSRxPin, SSTxPin);
+
+#elif defined(ESP8266)
+#include <SoftwareSerial.h>
+#pragma message("Using Software Serial for the ESP8266")
+SoftwareSerial modbusSerial;
+
+#elif defined(NRF52832_FEATHER) || defined(ARDUINO_NRF52840_FEATHER)
+#pragma message("Using TinyUSB for the NRF52")
+#include <Adafruit_TinyUSB.h>
+HardwareSerial& modbusSerial = Serial1;
+
+#elif !defined(NO_GLOBAL_SERIAL1) && !defined(STM32_CORE_VERSION)
+// This is just a assigning another name to the same port, for convenience
+// Unless it is unavailable, always prefer hardware serial.
+#pragma message("Using HardwareSerial / Serial1")
+HardwareSerial& modbusSerial = Serial1;
+
+#else
+// This is just a assigning another name to the same port, for convenience
+// Unless it is unavailable, always prefer hardware serial.
+#pragma message("Using HardwareSerial / Serial")
+HardwareSerial& modbusSerial = Serial;
+#endif
+
+// Construct the modbus slave instance
+modbusSlave slave;
+
+// ==========================================================================
+//  The Register Tables
+// ==========================================================================
+// Input registers 0-2: seconds since startup (2 registers, big endian) and a count of
+// loops since the last second
+uint16_t inputRegisters[3] = {0, 0, 0};
+// Holding register 100: a setting a master can change
+uint16_t holdingRegisters[1] = {42};
+// Coils 0-7: eight on/off switches a master can set
+byte coils[1] = {0x00};
+
+// Print every request; returning an exception code here would refuse it instead
+modbusErrorCode checkRequest(byte function, uint16_t address, uint16_t count) {
+    Serial.print(F("Request: function "));
+    Serial.print(function);
+    Serial.print(F(" address "));
+    Serial.print(address);
+    Serial.print(F(" count "));
+    Serial.println(count);
+    return NO_ERROR;
+}
+
+
+// ==========================================================================
+//  Arduino Setup Function
+// ==========================================================================
+void setup() {
+    // Turn on the "main" serial port for debugging via USB Serial Monitor
+    Serial.begin(serialBaud);
+
+    // Turn on your modbus serial port
+    modbusSerial.begin(modbusBaudRate);
+
+    // Start the slave and give it its tables
+    slave.begin(slaveID, modbusSerial, DEREPin);
+    slave.setInputRegisterTable(inputRegisters, 0, 3);
+    slave.setHoldingRegisterTable(holdingRegisters, 100, 1);
+    slave.setCoilTable(coils, 0, 8);
+    slave.setRequestHook(checkRequest);
+
+    Serial.println(F("\nRunning the 'simpleSlave()' example sketch."));
+}
+
+// ==========================================================================
+//  Arduino Loop Function
+// ==========================================================================
+uint32_t lastSecond = 0;
+uint16_t loops      = 0;
+
+void loop() {
+    // Keep the data up to date
+    loops++;
+    if (millis() - lastSecond >= 1000) {
+        lastSecond += 1000;
+        uint32_t seconds  = lastSecond / 1000;
+        inputRegisters[0] = seconds >> 16;
+        inputRegisters[1] = seconds & 0xFFFF;
+        inputRegisters[2] = loops;
+        loops             = 0;
+    }
+
+    // Answer any requests; this never waits
+    slave.task();
+}
@@ -0,0 +1,143 @@
+/**
+ * @file SensorModbusArbiter.cpp
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusArbiter class definitions.
+ */
+
+#include "SensorModbusArbiter.h"
+
+#ifdef MODBUSMASTER_HAS_ARBITER
+
+modbusArbiter::modbusArbiter(modbusMaster& master)
+    : _master(master), _head(&_stub), _tail(&_stub) {}
+
+
+//----------------------------------------------------------------------------
+//                           SUBMITTING REQUESTS
+//----------------------------------------------------------------------------
+
+void modbusArbiter::submit(modbusRequest& request) {
+    request.error = NO_ERROR;
+    request.bytes = 0;
+    request._done.store(false, std::memory_order_relaxed);
+    push(&request);
+}
+
+modbusErrorCode modbusArbiter::execute(modbusRequest& request) {
+    submit(request);
+    while (!request.isDone()) {
+        if (_waitHook != nullptr) {
+            _waitHook();
+        } else {
+            yield();
+        }
+    }
+    return request.error;
+}
+
+
+//----------------------------------------------------------------------------
+//                           THE BUS WORKER
+//----------------------------------------------------------------------------
+
+bool modbusArbiter::process(void) {
+    modbusRequest* request = pop();
+    if (request == nullptr) { return false; }
+    run(*request);
+    // Publish the results; the submitter may reuse the request right after this
+    request->_done.store(true, std::memory_order_release);
+    return true;
+}
+
+void modbusArbiter::run(modbusRequest& request) {
+    // Each request uses its own slave ID; put the master's back when done
+    byte oldSlaveID = _master.getSlaveID();
+    _master.setSlaveID(request.slaveID);
+
+    bool success = false;
+    switch (request.function) {
+        case 0x01:  // Coils
+        case 0x02:  // Discrete Inputs
+        case 0x03:  // Holding Registers
+        case 0x04:  // Input Registers
+            request.bytes = _master.getModbusData(request.slaveID, request.function,
+                                                  static_cast<int16_t>(request.start),
+                                                  static_cast<int16_t>(request.count));
+            success       = request.bytes > 0;
+            if (success && request.data != nullptr) {
+                memcpy(request.data, _master.responseBuffer + 3, request.bytes);
+            }
+            break;
+        case 0x05:  // Single coil
+            success = _master.setCoil(static_cast<int16_t>(request.start),
+                                      request.data != nullptr && (request.data[0] & 1));
+            break;
+        case 0x06:  // Single register
+        case 0x10:  // Multiple registers
+            success = _master.setRegisters(static_cast<int16_t>(request.start),
+                                           static_cast<int16_t>(request.count),
+                                           request.data, request.function == 0x10);
+            break;
+        case 0x0F:  // Multiple coils
+            success = _master.setCoils(static_cast<int16_t>(request.start),
+                                       static_cast<int16_t>(request.count),
+                                       request.data);
+            break;
+        default:
+            request.error = ILLEGAL_FUNCTION;
+            _master.setSlaveID(oldSlaveID);
+            return;
+    }
+
+    // Copy the error and timing out of the master while no one else can be using it
+    request.error  = _master.getLastError();
+    request.timing = _master.getLastTiming();
+    if (!success && request.error == NO_ERROR) { request.error = NO_RESPONSE; }
+    _master.setSlaveID(oldSlaveID);
+}
+
+
+//----------------------------------------------------------------------------
+//                           THE SUBMISSION QUEUE
+//----------------------------------------------------------------------------
+
+// This is an intrusive multi-producer, single-consumer queue: producers only swap the
+// head pointer, so submitting never blocks, and only the bus worker moves the tail.
+
+void modbusArbiter::push(modbusRequest* request) {
+    request->_next.store(nullptr, std::memory_order_relaxed);
+    modbusRequest* prev = _head.exchange(request, std::memory_order_acq_rel);
+    prev->_next.store(request, std::memory_order_release);
+}
+
+modbusRequest* modbusArbiter::pop(void) {
+    modbusRequest* tail = _tail;
+    modbusRequest* next = tail->_next.load(std::memory_order_acquire);
+    // Skip over the placeholder
+    if (tail == &_stub) {
+        if (next == nullptr) { return nullptr; }
+        _tail = next;
+        tail  = next;
+        next  = next->_next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+        _tail = next;
+        return tail;
+    }
+    // The tail is the last request linked in; if another is being pushed, wait for
+    // it to be linked before taking this one
+    if (tail != _head.load(std::memory_order_acquire)) { return nullptr; }
+    // Put the placeholder back behind the last request so it can be taken
+    push(&_stub);
+    next = tail->_next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        _tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+#endif  // MODBUSMASTER_HAS_ARBITER
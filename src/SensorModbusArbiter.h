@@ -0,0 +1,208 @@
+/**
+ * @file SensorModbusArbiter.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusArbiter class declarations.
+ *
+ * The arbiter lets several RTOS tasks or threads share one modbusMaster.  It is only
+ * available on platforms with the C++ \<atomic\> header (ie, ESP32, ESP8266, SAMD,
+ * native Linux builds); on AVR boards this file is empty.
+ */
+
+#ifndef SensorModbusArbiter_h
+#define SensorModbusArbiter_h
+
+#include "SensorModbusMaster.h"
+
+#if defined(__has_include)
+#if __has_include(<atomic>)
+/**
+ * @brief Defined if the modbusArbiter is available on this platform
+ */
+#define MODBUSMASTER_HAS_ARBITER
+#endif
+#endif
+
+#ifdef MODBUSMASTER_HAS_ARBITER
+
+#include <atomic>
+
+/**
+ * @brief A single modbus transaction submitted to a modbusArbiter.
+ *
+ * The caller fills in the request, submits it, and must keep it (and its buffer)
+ * alive and untouched until isDone() returns true.  The results are then in the
+ * request itself, never in the shared state of the modbusMaster.
+ *
+ * Supported function codes:
+ * - 0x01-0x04: read count coils, inputs, or registers into data
+ * - 0x05: set the single coil at start to the first bit of data[0]
+ * - 0x06 or 0x10: write count registers from data
+ * - 0x0F: write count coils from data
+ */
+struct modbusRequest {
+    byte            slaveID;   ///< The slave to talk to
+    byte            function;  ///< The modbus function code
+    uint16_t        start;     ///< The first coil, input, or register
+    uint16_t        count;     ///< The number of coils, inputs, or registers
+    byte*           data;      ///< The data to write, or the buffer for read data
+    modbusErrorCode error;     ///< The result of the request; #NO_ERROR on success
+    int16_t         bytes;     ///< The data bytes read; 0 for writes or on failure
+    modbusTiming    timing;    ///< The timing of the last transaction sent
+
+    /**
+     * @brief Construct a new, empty modbus request
+     */
+    modbusRequest()
+        : slaveID(0),
+          function(0),
+          start(0),
+          count(0),
+          data(nullptr),
+          error(NO_ERROR),
+          bytes(0),
+          timing(),
+          _done(true),
+          _next(nullptr) {}
+    /**
+     * @brief Construct a new modbus request
+     *
+     * @param slave The slave to talk to
+     * @param functionCode The modbus function code
+     * @param startAddress The first coil, input, or register
+     * @param numValues The number of coils, inputs, or registers
+     * @param buffer The data to write, or the buffer to copy read data into
+     */
+    modbusRequest(byte slave, byte functionCode, uint16_t startAddress,
+                  uint16_t numValues, byte* buffer)
+        : slaveID(slave),
+          function(functionCode),
+          start(startAddress),
+          count(numValues),
+          data(buffer),
+          error(NO_ERROR),
+          bytes(0),
+          timing(),
+          _done(true),
+          _next(nullptr) {}
+
+    /**
+     * @brief Check if the bus worker has finished the request
+     *
+     * @return True if the results are ready.
+     */
+    bool isDone() const {
+        return _done.load(std::memory_order_acquire);
+    }
+
+ private:
+    modbusRequest(const modbusRequest&)            = delete;
+    modbusRequest& operator=(const modbusRequest&) = delete;
+
+    friend class modbusArbiter;
+    std::atomic<bool>           _done;  ///< Set by the worker when finished
+    std::atomic<modbusRequest*> _next;  ///< The next request in the queue
+};
+
+/**
+ * @brief Serializes whole modbus transactions from many tasks onto one modbusMaster.
+ *
+ * Any number of tasks may call submit() or execute() at once; submission is a
+ * lock-free multi-producer, single-consumer queue.  Exactly one task - the bus worker
+ * - calls process() in a loop; only that task ever touches the modbusMaster.  Each
+ * request carries its own slave ID and gets its own results, so tasks never see each
+ * other's slave IDs or errors.
+ *
+ * @note While an arbiter is in use, do not call the modbusMaster directly from any
+ * other task.
+ */
+class modbusArbiter {
+ public:
+    /**
+     * @brief A function to call while waiting for a request to finish
+     */
+    typedef void (*waitHook)(void);
+
+    /**
+     * @brief Construct a new modbus Arbiter object
+     *
+     * @param master The modbusMaster to share.  It must already have begun.
+     */
+    explicit modbusArbiter(modbusMaster& master);
+
+    /**
+     * @brief Queue a request for the bus worker and return immediately
+     *
+     * Safe to call from any number of tasks at once.  Poll the request's isDone()
+     * before reading the results.
+     *
+     * @param request The request to queue.  It must not already be queued.
+     */
+    void submit(modbusRequest& request);
+    /**
+     * @brief Queue a request and wait for the bus worker to finish it
+     *
+     * @param request The request to run.
+     * @return The result of the request.
+     */
+    modbusErrorCode execute(modbusRequest& request);
+    /**
+     * @brief Set the function to call while execute() waits
+     *
+     * @param hook The function to call; nullptr to call yield().
+     */
+    void setWaitHook(waitHook hook) {
+        _waitHook = hook;
+    }
+
+    /**
+     * @brief Run the next queued request, if any
+     *
+     * Only the bus worker may call this.
+     *
+     * @return True if a request was run.
+     */
+    bool process(void);
+
+ private:
+    /**
+     * @brief Take the oldest request off the queue
+     *
+     * @return The request; nullptr if the queue is empty or a submission is part way
+     * through being linked in.
+     */
+    modbusRequest* pop(void);
+    /**
+     * @brief Link a request onto the end of the queue
+     *
+     * @param request The request to add
+     */
+    void push(modbusRequest* request);
+    /**
+     * @brief Run a request on the modbusMaster and record its results
+     *
+     * @param request The request to run
+     */
+    void run(modbusRequest& request);
+
+    modbusMaster& _master;              ///< The shared modbusMaster
+    waitHook      _waitHook = nullptr;  ///< Called while execute() waits
+    /**
+     * @brief A placeholder that keeps the queue from ever being truly empty
+     */
+    modbusRequest _stub;
+    /**
+     * @brief The newest request in the queue; written by every producer
+     */
+    std::atomic<modbusRequest*> _head;
+    /**
+     * @brief The oldest request in the queue; only used by the bus worker
+     */
+    modbusRequest* _tail;
+};
+
+#endif  // MODBUSMASTER_HAS_ARBITER
+
+#endif
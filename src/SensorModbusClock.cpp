@@ -0,0 +1,74 @@
+/**
+ * @file SensorModbusClock.cpp
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusVirtualClock definitions.
+ */
+
+#include "SensorModbusMaster.h"
+
+#ifdef MODBUSMASTER_VIRTUAL_CLOCK
+
+uint64_t                      modbusVirtualClock::_now     = 0;
+bool                          modbusVirtualClock::_inTasks = false;
+modbusVirtualClock::clockTask modbusVirtualClock::_tasks[MODBUS_CLOCK_MAX_TASKS] = {};
+void* modbusVirtualClock::_contexts[MODBUS_CLOCK_MAX_TASKS]                      = {};
+
+bool modbusVirtualClock::addTask(clockTask task, void* context) {
+    for (uint8_t i = 0; i < MODBUS_CLOCK_MAX_TASKS; i++) {
+        if (_tasks[i] == nullptr) {
+            _tasks[i]    = task;
+            _contexts[i] = context;
+            return true;
+        }
+    }
+    return false;
+}
+
+void modbusVirtualClock::removeTask(clockTask task, void* context) {
+    for (uint8_t i = 0; i < MODBUS_CLOCK_MAX_TASKS; i++) {
+        if (_tasks[i] == task && _contexts[i] == context) {
+            _tasks[i]    = nullptr;
+            _contexts[i] = nullptr;
+        }
+    }
+}
+
+uint64_t modbusVirtualClock::runTasks(void) {
+    uint64_t next = UINT64_MAX;
+    _inTasks      = true;
+    for (uint8_t i = 0; i < MODBUS_CLOCK_MAX_TASKS; i++) {
+        if (_tasks[i] == nullptr) { continue; }
+        uint64_t event = _tasks[i](_contexts[i]);
+        if (event > _now && event < next) { next = event; }
+    }
+    _inTasks = false;
+    return next;
+}
+
+void modbusVirtualClock::advance(uint64_t us) {
+    // A task waiting (ie, a slave flushing its output) must not move the clock under
+    // the other tasks
+    if (_inTasks) { return; }
+    uint64_t target = _now + us;
+    do {
+        // Jump to the earliest of the next event, one step, or the end of the wait
+        uint64_t next = runTasks();
+        uint64_t step = _now + MODBUS_CLOCK_STEP;
+        if (next < step) { step = next; }
+        if (target < step) { step = target; }
+        _now = step;
+    } while (_now < target);
+    runTasks();
+}
+
+void modbusVirtualClock::idle(void) {
+    if (_inTasks) { return; }
+    uint64_t next = runTasks();
+    uint64_t step = _now + MODBUS_CLOCK_STEP;
+    advance((next < step ? next : step) - _now);
+}
+
+#endif  // MODBUSMASTER_VIRTUAL_CLOCK
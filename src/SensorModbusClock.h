@@ -0,0 +1,179 @@
+/**
+ * @file SensorModbusClock.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the timing macros used by the library and the optional virtual
+ * clock behind them.
+ *
+ * Every time the library reads the clock or waits, it goes through the MODBUS_MILLIS(),
+ * MODBUS_MICROS(), MODBUS_DELAY(), MODBUS_DELAY_MICROS(), and MODBUS_IDLE() macros.
+ * Normally these are the Arduino functions.  If MODBUSMASTER_VIRTUAL_CLOCK is defined
+ * in the build flags, they use modbusVirtualClock instead, whose time only moves when
+ * the library waits.  With a modbusSimLine in place of a serial port, thousands of
+ * requests, timeouts, and retries can then be run in a fraction of a second with
+ * exactly repeatable timing.
+ */
+
+#ifndef SensorModbusClock_h
+#define SensorModbusClock_h
+
+#include <Arduino.h>
+
+#ifdef MODBUSMASTER_VIRTUAL_CLOCK
+
+/**
+ * @brief The most tasks that can be run by the virtual clock
+ */
+#define MODBUS_CLOCK_MAX_TASKS 8
+/**
+ * @brief The largest single step of the virtual clock (in µs)
+ *
+ * Time never jumps further than this at once, so anything polling the clock sees it
+ * move at about the resolution of millis().
+ */
+#define MODBUS_CLOCK_STEP 1000
+
+/**
+ * @brief A simulated clock that only moves forward when the program waits.
+ *
+ * Each party in a simulation (ie, a modbusSlave, a modbusSimLine) registers a task.
+ * Whenever the clock moves, it first runs every task; each task returns the time of
+ * its next event, and the clock then jumps straight to the earliest event, one step,
+ * or the end of the wait, whichever comes first.  Waiting 500 ms for a slave that
+ * never answers takes 500 steps instead of half a second.
+ *
+ * The clock is shared by everything in the program and is not thread safe.
+ */
+class modbusVirtualClock {
+ public:
+    /**
+     * @brief A task run each time the clock moves
+     *
+     * @param context The context given when the task was added.
+     * @return The time of the task's next event (in µs), or UINT64_MAX for none.
+     */
+    typedef uint64_t (*clockTask)(void* context);
+
+    /**
+     * @brief Get the current time in milliseconds
+     *
+     * @return The time in milliseconds.
+     */
+    static uint32_t millis() {
+        return static_cast<uint32_t>(_now / 1000);
+    }
+    /**
+     * @brief Get the current time in microseconds
+     *
+     * @return The time in microseconds.
+     */
+    static uint32_t micros() {
+        return static_cast<uint32_t>(_now);
+    }
+    /**
+     * @brief Get the current time in microseconds without wrapping
+     *
+     * @return The time in microseconds.
+     */
+    static uint64_t now() {
+        return _now;
+    }
+    /**
+     * @brief Wait, moving the clock forward
+     *
+     * @param ms The time to wait in milliseconds.
+     */
+    static void delay(uint32_t ms) {
+        advance(static_cast<uint64_t>(ms) * 1000);
+    }
+    /**
+     * @brief Wait, moving the clock forward
+     *
+     * @param us The time to wait in microseconds.
+     */
+    static void delayMicros(uint32_t us) {
+        advance(us);
+    }
+    /**
+     * @brief Wait for the next thing to happen: the next event of any task or one
+     * step, whichever comes first
+     */
+    static void idle(void);
+    /**
+     * @brief Move the clock forward, running the tasks along the way
+     *
+     * If called from within a task, this does nothing.
+     *
+     * @param us The time to move forward in microseconds.
+     */
+    static void advance(uint64_t us);
+    /**
+     * @brief Set the clock to a time
+     *
+     * @param us The new time in microseconds. Optional with a default of 0.
+     */
+    static void reset(uint64_t us = 0) {
+        _now = us;
+    }
+
+    /**
+     * @brief Add a task to be run whenever the clock moves
+     *
+     * @param task The task to run.
+     * @param context The context to give the task.
+     * @return True if the task was added; false if there is no room.
+     */
+    static bool addTask(clockTask task, void* context);
+    /**
+     * @brief Remove a task
+     *
+     * @param task The task to remove.
+     * @param context The context it was added with.
+     */
+    static void removeTask(clockTask task, void* context);
+
+ private:
+    /**
+     * @brief Run every task
+     *
+     * @return The time of the earliest event after now; UINT64_MAX for none.
+     */
+    static uint64_t runTasks(void);
+
+    static uint64_t  _now;                              ///< The current time (µs)
+    static bool      _inTasks;                          ///< True while tasks run
+    static clockTask _tasks[MODBUS_CLOCK_MAX_TASKS];    ///< The tasks
+    static void*     _contexts[MODBUS_CLOCK_MAX_TASKS]; ///< The task contexts
+};
+
+/// Get the time in ms from the virtual clock
+#define MODBUS_MILLIS() modbusVirtualClock::millis()
+/// Get the time in µs from the virtual clock
+#define MODBUS_MICROS() modbusVirtualClock::micros()
+/// Wait on the virtual clock
+#define MODBUS_DELAY(ms) modbusVirtualClock::delay(ms)
+/// Wait on the virtual clock (in µs)
+#define MODBUS_DELAY_MICROS(us) modbusVirtualClock::delayMicros(us)
+/// Let the virtual clock move to the next event while spinning
+#define MODBUS_IDLE() modbusVirtualClock::idle()
+
+#else
+
+/// Get the time in ms
+#define MODBUS_MILLIS() millis()
+/// Get the time in µs
+#define MODBUS_MICROS() micros()
+/// Wait
+#define MODBUS_DELAY(ms) delay(ms)
+/// Wait (in µs)
+#define MODBUS_DELAY_MICROS(us) delayMicroseconds(us)
+/// Nothing; spinning on real hardware lets real time pass
+#define MODBUS_IDLE() \
+    do {              \
+    } while (0)
+
+#endif  // MODBUSMASTER_VIRTUAL_CLOCK
+
+#endif
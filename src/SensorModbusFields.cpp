@@ -0,0 +1,60 @@
+/**
+ * @file SensorModbusFields.cpp
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the field decoding and encoding functions.
+ */
+
+#include "SensorModbusFields.h"
+
+// NOTE:  As in the rest of the library, this assumes the processor is little endian,
+// so big endian values have their bytes reversed and little endian values are copied.
+
+uint8_t decodeFields(void* out, const modbusFieldDescriptor* fields, uint8_t numFields,
+                     const modbusFrameView* frames, uint8_t numFrames) {
+    byte*   dest    = static_cast<byte*>(out);
+    uint8_t decoded = 0;
+    for (uint8_t i = 0; i < numFields; i++) {
+        const modbusFieldDescriptor& field = fields[i];
+        if (field.frame >= numFrames) { continue; }
+        const modbusFrameView& frame = frames[field.frame];
+        uint8_t  width = modbusFrameView::registersFor(field.type) * 2;
+        uint16_t first = field.index * 2;
+        if (!frame.valid() || first + width > frame.size()) { continue; }
+
+        const byte* src    = frame.data() + first;
+        byte*       member = dest + field.member;
+        if (field.endian == bigEndian) {
+            for (uint8_t b = 0; b < width; b++) { member[b] = src[width - 1 - b]; }
+        } else {
+            memcpy(member, src, width);
+        }
+        decoded++;
+    }
+    return decoded;
+}
+
+uint8_t encodeFields(const void* in, const modbusFieldDescriptor* fields,
+                     uint8_t numFields, byte* data, uint16_t dataSize, uint8_t frame) {
+    const byte* source  = static_cast<const byte*>(in);
+    uint8_t     encoded = 0;
+    for (uint8_t i = 0; i < numFields; i++) {
+        const modbusFieldDescriptor& field = fields[i];
+        if (field.frame != frame) { continue; }
+        uint8_t  width = modbusFrameView::registersFor(field.type) * 2;
+        uint16_t first = field.index * 2;
+        if (first + width > dataSize) { continue; }
+
+        const byte* member = source + field.member;
+        byte*       dest   = data + first;
+        if (field.endian == bigEndian) {
+            for (uint8_t b = 0; b < width; b++) { dest[b] = member[width - 1 - b]; }
+        } else {
+            memcpy(dest, member, width);
+        }
+        encoded++;
+    }
+    return encoded;
+}
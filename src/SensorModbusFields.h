@@ -0,0 +1,167 @@
+/**
+ * @file SensorModbusFields.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the field descriptor tables and the functions to decode register
+ * data into a struct, or encode a struct into register data, in one pass.
+ *
+ * Describe where each member of a struct is in the register data with #MODBUS_FIELD:
+ * @code{.cpp}
+ * struct sondeConfig {
+ *     float    offset;
+ *     float    slope;
+ *     uint16_t interval;
+ * };
+ * const modbusFieldDescriptor configFields[] = {
+ *     MODBUS_FIELD(sondeConfig, offset, 0, 0, float32Value, bigEndian),
+ *     MODBUS_FIELD(sondeConfig, slope, 0, 2, float32Value, bigEndian),
+ *     MODBUS_FIELD(sondeConfig, interval, 0, 4, uint16Value, bigEndian),
+ * };
+ *
+ * sondeConfig config;
+ * decodeInto(config, configFields, 3, modbus.getRegisterView(0x03, 0x200, 5));
+ * config.interval = 60;
+ * byte data[10];
+ * encodeFrom(config, configFields, 3, data, 10);
+ * modbus.setRegisters(0x200, 5, data);
+ * @endcode
+ *
+ * Each value is copied straight from the data into its member, reversing the bytes if
+ * the value is big endian; there are no intermediate frames or offset calculations.
+ */
+
+#ifndef SensorModbusFields_h
+#define SensorModbusFields_h
+
+#include "SensorModbusMaster.h"
+#include <stddef.h>
+
+/**
+ * @brief Describe where a struct member is in register data
+ *
+ * @param structType The struct holding the value
+ * @param member The member of the struct; it must be of the size of the type: a
+ * uint16_t or int16_t for 16-bit values, a uint32_t, int32_t, or float for 32-bit ones.
+ * @param frame The index of the frame the value is in; 0 if there is only one.
+ * @param index The index of the first register of the value within the frame.
+ * @param type The #modbusDataType of the value
+ * @param endian The #endianness of the value
+ */
+#define MODBUS_FIELD(structType, member, frame, index, type, endian)                  \
+    {                                                                                \
+        frame, index, type, endian,                                                  \
+            modbusFieldCheck<sizeof(static_cast<structType*>(nullptr)->member),      \
+                             type>::offset(offsetof(structType, member))             \
+    }
+
+/**
+ * @brief Checks at compile time that a member is the size of its field type
+ *
+ * @tparam MemberSize The size of the member
+ * @tparam Type The #modbusDataType of the field
+ */
+template <size_t MemberSize, modbusDataType Type>
+struct modbusFieldCheck {
+    static_assert(MemberSize == modbusFrameView::registersFor(Type) * 2,
+                  "MODBUS_FIELD: the member is not the size of the field type");
+    /**
+     * @brief Pass the offset of the member through once it has been checked
+     *
+     * @param memberOffset The offset of the member within the struct
+     * @return The offset.
+     */
+    static constexpr uint16_t offset(size_t memberOffset) {
+        return static_cast<uint16_t>(memberOffset);
+    }
+};
+
+/**
+ * @brief Where a struct member is in register data; create these with #MODBUS_FIELD.
+ */
+typedef struct modbusFieldDescriptor {
+    uint8_t        frame;   ///< The index of the frame the value is in
+    uint16_t       index;   ///< The first register of the value within the frame
+    modbusDataType type;    ///< The type of the value
+    endianness     endian;  ///< The endianness of the value
+    uint16_t       member;  ///< The offset of the member within the struct
+} modbusFieldDescriptor;
+
+/**
+ * @brief Decode register data from several frames into the members of a struct
+ *
+ * The frames must be independent; a view from getRegisterView() is overwritten by
+ * the next command, so copy each response into your own buffer and make a view of it
+ * before reading the next one.
+ *
+ * @param out A pointer to the struct to put the values in
+ * @param fields The descriptions of the members
+ * @param numFields The number of descriptions
+ * @param frames The frames of register data
+ * @param numFrames The number of frames
+ * @return The number of members filled; members whose registers are not in the
+ * frames are left unchanged.
+ */
+uint8_t decodeFields(void* out, const modbusFieldDescriptor* fields, uint8_t numFields,
+                     const modbusFrameView* frames, uint8_t numFrames);
+/**
+ * @brief Encode the members of a struct into register data
+ *
+ * @param in A pointer to the struct to take the values from
+ * @param fields The descriptions of the members
+ * @param numFields The number of descriptions
+ * @param data The buffer for the register data
+ * @param dataSize The size of the buffer in bytes
+ * @param frame The frame to encode; only the members in this frame are written.
+ * @return The number of members written; members whose registers do not fit in the
+ * buffer are skipped.
+ */
+uint8_t encodeFields(const void* in, const modbusFieldDescriptor* fields,
+                     uint8_t numFields, byte* data, uint16_t dataSize, uint8_t frame);
+
+/**
+ * @brief Decode the register data in a frame into a struct
+ *
+ * @tparam S The struct holding the values
+ * @param out The struct to put the values in
+ * @param fields The descriptions of the members; only those in frame 0 are used.
+ * @param numFields The number of descriptions
+ * @param frame The register data
+ * @return The number of members filled.
+ */
+template <typename S>
+uint8_t decodeInto(S& out, const modbusFieldDescriptor* fields, uint8_t numFields,
+                   const modbusFrameView& frame) {
+    return decodeFields(&out, fields, numFields, &frame, 1);
+}
+/**
+ * @brief Decode the register data in several frames into a struct
+ *
+ * @tparam S The struct holding the values
+ * @copydetails decodeFields()
+ */
+template <typename S>
+uint8_t decodeInto(S& out, const modbusFieldDescriptor* fields, uint8_t numFields,
+                   const modbusFrameView* frames, uint8_t numFrames) {
+    return decodeFields(&out, fields, numFields, frames, numFrames);
+}
+/**
+ * @brief Encode a struct into register data
+ *
+ * @tparam S The struct holding the values
+ * @param in The struct to take the values from
+ * @param fields The descriptions of the members
+ * @param numFields The number of descriptions
+ * @param data The buffer for the register data
+ * @param dataSize The size of the buffer in bytes
+ * @param frame The frame to encode. Optional with a default of 0.
+ * @return The number of members written.
+ */
+template <typename S>
+uint8_t encodeFrom(const S& in, const modbusFieldDescriptor* fields, uint8_t numFields,
+                   byte* data, uint16_t dataSize, uint8_t frame = 0) {
+    return encodeFields(&in, fields, numFields, data, dataSize, frame);
+}
+
+#endif
@@ -0,0 +1,276 @@
+/**
+ * @file SensorModbusFrames.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the constexpr modbus frame builders and CRC.
+ *
+ * With constant arguments, these build complete request frames, CRC included, at
+ * compile time:
+ * @code{.cpp}
+ * constexpr modbusFrame<8> wakeFrame = modbusWriteCoilFrame(0x01, 0x0010, true);
+ * static_assert(wakeFrame.valid(), "bad wake frame");
+ * ...
+ * modbus.sendFrame(wakeFrame);
+ * @endcode
+ *
+ * These only need C++11.  Each function is a single expression, so they can also be
+ * called at run time, but the runtime functions of modbusMaster are faster there.
+ */
+
+#ifndef SensorModbusFrames_h
+#define SensorModbusFrames_h
+
+#include <Arduino.h>
+
+/**
+ * @brief Add a byte to a modbus CRC at compile time
+ *
+ * @param crc The CRC so far; start with 0xFFFF.
+ * @param value The byte to add
+ * @return The new CRC.
+ */
+constexpr uint16_t modbusCrcUpdate(uint16_t crc, uint8_t value);
+
+/// @cond
+// Shifts the CRC one bit at a time
+constexpr uint16_t modbusCrcShift(uint16_t crc, uint8_t bits) {
+    return bits == 0
+        ? crc
+        : modbusCrcShift((crc & 0x0001) ? (crc >> 1) ^ 0xA001 : crc >> 1, bits - 1);
+}
+/// @endcond
+
+constexpr uint16_t modbusCrcUpdate(uint16_t crc, uint8_t value) {
+    return modbusCrcShift(crc ^ value, 8);
+}
+
+/**
+ * @brief A complete modbus RTU frame, built at compile time.
+ *
+ * @tparam N The length of the frame, including the CRC
+ */
+template <uint16_t N>
+struct modbusFrame {
+    static_assert(N >= 4 && N <= 256, "A modbus RTU frame is 4 to 256 bytes long");
+
+    byte data[N];  ///< The bytes of the frame
+
+    /**
+     * @brief Get the length of the frame
+     *
+     * @return The length of the frame, including the CRC.
+     */
+    constexpr uint16_t length() const {
+        return N;
+    }
+    /**
+     * @brief Get the CRC of the start of the frame
+     *
+     * @param n The number of bytes to include
+     * @return The CRC of the first n bytes.
+     */
+    constexpr uint16_t crcOf(uint16_t n) const {
+        return n == 0 ? 0xFFFF : modbusCrcUpdate(crcOf(n - 1), data[n - 1]);
+    }
+    /**
+     * @brief Check that the CRC at the end of the frame is right
+     *
+     * @return True if the CRC is right.
+     */
+    constexpr bool crcValid() const {
+        return data[N - 2] == (crcOf(N - 2) & 0xFF) &&
+            data[N - 1] == (crcOf(N - 2) >> 8);
+    }
+    /**
+     * @brief Check that the frame is a well formed request
+     *
+     * This checks the CRC and, for the functions this library builds frames for (0x01
+     * to 0x06, 0x0F, and 0x10), the length of the frame and the number of values
+     * against the modbus limits.
+     *
+     * @return True if the frame is a well formed request.
+     */
+    constexpr bool valid() const {
+        return crcValid() && data[0] <= 247 && functionValid();
+    }
+
+ private:
+    /// @cond
+    constexpr uint16_t wordAt(uint16_t i) const {
+        return static_cast<uint16_t>((data[i] << 8) | data[i + 1]);
+    }
+    constexpr bool functionValid() const {
+        return (data[1] == 0x01 || data[1] == 0x02)
+            ? N == 8 && wordAt(4) >= 1 && wordAt(4) <= 2000
+            : (data[1] == 0x03 || data[1] == 0x04)
+            ? N == 8 && wordAt(4) >= 1 && wordAt(4) <= 125
+            : data[1] == 0x05 ? N == 8 && (wordAt(4) == 0xFF00 || wordAt(4) == 0x0000)
+            : data[1] == 0x06 ? N == 8
+            : data[1] == 0x0F
+            ? N >= 10 && wordAt(4) >= 1 && wordAt(4) <= 1968 &&
+                data[6] == (wordAt(4) + 7) / 8 && N == 9 + data[6]
+            : data[1] == 0x10
+            ? N >= 11 && wordAt(4) >= 1 && wordAt(4) <= 123 &&
+                data[6] == wordAt(4) * 2 && N == 9 + data[6]
+            : true;
+    }
+    /// @endcond
+};
+
+/// @cond
+// A list of indices, to expand into the bytes of a frame
+template <uint16_t... I>
+struct modbusIndices {};
+template <uint16_t N, uint16_t... I>
+struct modbusMakeIndices : modbusMakeIndices<N - 1, N - 1, I...> {};
+template <uint16_t... I>
+struct modbusMakeIndices<0, I...> {
+    typedef modbusIndices<I...> type;
+};
+
+// The CRC of the first n bytes of a frame body
+template <typename Body>
+constexpr uint16_t modbusBodyCrc(const Body& body, uint16_t n) {
+    return n == 0 ? 0xFFFF
+                  : modbusCrcUpdate(modbusBodyCrc(body, n - 1), body.at(n - 1));
+}
+// A byte of the frame: the body, then the CRC low byte first
+template <typename Body>
+constexpr byte modbusFrameByte(const Body& body, uint16_t i) {
+    return i < Body::length ? body.at(i)
+        : i == Body::length
+        ? static_cast<byte>(modbusBodyCrc(body, Body::length) & 0xFF)
+        : static_cast<byte>(modbusBodyCrc(body, Body::length) >> 8);
+}
+template <typename Body, uint16_t... I>
+constexpr modbusFrame<sizeof...(I)> modbusBuildFrame(const Body& body,
+                                                     modbusIndices<I...>) {
+    return {{modbusFrameByte(body, I)...}};
+}
+template <typename Body>
+constexpr modbusFrame<Body::length + 2> modbusBuildFrame(const Body& body) {
+    return modbusBuildFrame(body, typename modbusMakeIndices<Body::length + 2>::type());
+}
+
+// The bodies of the frames: slave, function, then two 16-bit words
+struct modbusWordsBody {
+    static constexpr uint16_t length = 6;
+    byte                      slaveID;
+    byte                      function;
+    uint16_t                  first;
+    uint16_t                  second;
+    constexpr byte            at(uint16_t i) const {
+        return i == 0 ? slaveID
+            : i == 1  ? function
+            : i == 2  ? static_cast<byte>(first >> 8)
+            : i == 3  ? static_cast<byte>(first & 0xFF)
+            : i == 4  ? static_cast<byte>(second >> 8)
+                      : static_cast<byte>(second & 0xFF);
+    }
+};
+// Slave, 0x10, start, count, byte count, then the registers
+template <uint16_t K>
+struct modbusRegistersBody {
+    static constexpr uint16_t length = 7 + 2 * K;
+    byte                      slaveID;
+    uint16_t                  start;
+    uint16_t                  values[K];
+    constexpr byte            at(uint16_t i) const {
+        return i < 6 ? modbusWordsBody{slaveID, 0x10, start, K}.at(i)
+            : i == 6 ? static_cast<byte>(2 * K)
+            : (i - 7) % 2 == 0 ? static_cast<byte>(values[(i - 7) / 2] >> 8)
+                               : static_cast<byte>(values[(i - 7) / 2] & 0xFF);
+    }
+};
+// Slave, 0x0F, start, count, byte count, then the packed coils
+template <uint16_t K>
+struct modbusCoilsBody {
+    static constexpr uint16_t length = 7 + (K + 7) / 8;
+    byte                      slaveID;
+    uint16_t                  start;
+    bool                      values[K];
+    constexpr byte            packed(uint16_t first, uint8_t bit) const {
+        return bit == 8 || first + bit >= K
+            ? 0
+            : static_cast<byte>((values[first + bit] ? 1 << bit : 0) |
+                                packed(first, bit + 1));
+    }
+    constexpr byte at(uint16_t i) const {
+        return i < 6 ? modbusWordsBody{slaveID, 0x0F, start, K}.at(i)
+            : i == 6 ? static_cast<byte>((K + 7) / 8)
+                     : packed((i - 7) * 8, 0);
+    }
+};
+/// @endcond
+
+/**
+ * @brief Build a frame to read coils (0x01), discrete inputs (0x02), holding
+ * registers (0x03), or input registers (0x04)
+ *
+ * @param slaveID The modbus slave ID of the device
+ * @param readCommand The read command
+ * @param startAddress The first coil, input, or register to read
+ * @param count The number of coils, inputs, or registers to read
+ * @return The complete frame.
+ */
+constexpr modbusFrame<8> modbusReadFrame(byte slaveID, byte readCommand,
+                                         uint16_t startAddress, uint16_t count) {
+    return modbusBuildFrame(modbusWordsBody{slaveID, readCommand, startAddress, count});
+}
+/**
+ * @brief Build a frame to set a single holding register (0x06)
+ *
+ * @param slaveID The modbus slave ID of the device
+ * @param regNum The register to set
+ * @param value The value to set it to
+ * @return The complete frame.
+ */
+constexpr modbusFrame<8> modbusWriteRegisterFrame(byte slaveID, uint16_t regNum,
+                                                  uint16_t value) {
+    return modbusBuildFrame(modbusWordsBody{slaveID, 0x06, regNum, value});
+}
+/**
+ * @brief Build a frame to set a single coil (0x05)
+ *
+ * @param slaveID The modbus slave ID of the device
+ * @param coilAddress The coil to set
+ * @param value The state to set it to
+ * @return The complete frame.
+ */
+constexpr modbusFrame<8> modbusWriteCoilFrame(byte slaveID, uint16_t coilAddress,
+                                              bool value) {
+    return modbusBuildFrame(modbusWordsBody{slaveID, 0x05, coilAddress,
+                                            value ? uint16_t(0xFF00) : uint16_t(0)});
+}
+/**
+ * @brief Build a frame to set several holding registers (0x10)
+ *
+ * @param slaveID The modbus slave ID of the device
+ * @param startRegister The first register to set
+ * @param values The values to set the registers to, one per register
+ * @return The complete frame.
+ */
+template <typename... Values>
+constexpr modbusFrame<9 + 2 * sizeof...(Values)> modbusWriteRegistersFrame(
+    byte slaveID, uint16_t startRegister, Values... values) {
+    return modbusBuildFrame(modbusRegistersBody<sizeof...(Values)>{
+        slaveID, startRegister, {static_cast<uint16_t>(values)...}});
+}
+/**
+ * @brief Build a frame to set several coils (0x0F)
+ *
+ * @param slaveID The modbus slave ID of the device
+ * @param startAddress The first coil to set
+ * @param values The states to set the coils to, one per coil
+ * @return The complete frame.
+ */
+template <typename... Values>
+constexpr modbusFrame<9 + (sizeof...(Values) + 7) / 8> modbusWriteCoilsFrame(
+    byte slaveID, uint16_t startAddress, Values... values) {
+    return modbusBuildFrame(modbusCoilsBody<sizeof...(Values)>{
+        slaveID, startAddress, {static_cast<bool>(values)...}});
+}
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file SensorModbusKernels.cpp
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the bulk conversion function definitions.
+ */
+
+#include "SensorModbusKernels.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Each kernel handles whole 16 byte vectors, then finishes the rest one value at a
+// time.
+
+void modbusSwap16(const byte* src, void* dest, uint16_t count) {
+    byte*    out   = static_cast<byte*>(dest);
+    uint32_t bytes = static_cast<uint32_t>(count) * 2;
+    uint32_t i     = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        v         = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= bytes; i += 16) {
+        vst1q_u8(out + i, vrev16q_u8(vld1q_u8(src + i)));
+    }
+#elif !defined(__AVR__)
+    // Two registers to a word
+    for (; i + 4 <= bytes; i += 4) {
+        uint32_t w;
+        memcpy(&w, src + i, 4);
+        w = ((w & 0x00FF00FFUL) << 8) | ((w >> 8) & 0x00FF00FFUL);
+        memcpy(out + i, &w, 4);
+    }
+#endif
+    for (; i < bytes; i += 2) {
+        byte high  = src[i];
+        out[i]     = src[i + 1];
+        out[i + 1] = high;
+    }
+}
+
+void modbusSwap32(const byte* src, void* dest, uint16_t count) {
+    byte*    out   = static_cast<byte*>(dest);
+    uint32_t bytes = static_cast<uint32_t>(count) * 4;
+    uint32_t i     = 0;
+#if defined(__SSSE3__)
+    const __m128i order = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1,
+                                       2, 3);
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_shuffle_epi8(v, order));
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // Swap the bytes of each half, then the halves of each value
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= bytes; i += 16) {
+        vst1q_u8(out + i, vrev32q_u8(vld1q_u8(src + i)));
+    }
+#endif
+    for (; i < bytes; i += 4) {
+        byte b0    = src[i];
+        byte b1    = src[i + 1];
+        out[i]     = src[i + 3];
+        out[i + 1] = src[i + 2];
+        out[i + 2] = b1;
+        out[i + 3] = b0;
+    }
+}
+
+#if !defined(__SSE2__) && !defined(__ARM_NEON) && !defined(__AVR__)
+// The four states in each nibble, one to a byte, in memory order
+static const uint32_t nibbleStates[16] = {
+    0x00000000UL, 0x00000001UL, 0x00000100UL, 0x00000101UL,
+    0x00010000UL, 0x00010001UL, 0x00010100UL, 0x00010101UL,
+    0x01000000UL, 0x01000001UL, 0x01000100UL, 0x01000101UL,
+    0x01010000UL, 0x01010001UL, 0x01010100UL, 0x01010101UL};
+#endif
+
+void modbusUnpackBits(const byte* src, void* dest, uint16_t count) {
+    byte*    out = static_cast<byte*>(dest);
+    uint16_t i   = 0;
+#if defined(__SSE2__)
+    // Spread two source bytes over 16 output bytes, then test one bit in each
+    const __m128i bits = _mm_set_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16,
+                                      8, 4, 2, 1);
+    const __m128i one  = _mm_set1_epi8(1);
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_cvtsi32_si128(src[i / 8] | (src[i / 8 + 1] << 8));
+        v         = _mm_unpacklo_epi8(v, v);
+        v         = _mm_unpacklo_epi16(v, v);
+        v         = _mm_unpacklo_epi32(v, v);
+        v         = _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_and_si128(v, one));
+    }
+#elif defined(__ARM_NEON)
+    static const uint8_t bitValues[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                          1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t     bits          = vld1q_u8(bitValues);
+    const uint8x16_t     one           = vdupq_n_u8(1);
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t v = vcombine_u8(vdup_n_u8(src[i / 8]), vdup_n_u8(src[i / 8 + 1]));
+        vst1q_u8(out + i, vandq_u8(vtstq_u8(v, bits), one));
+    }
+#elif !defined(__AVR__)
+    for (; i + 8 <= count; i += 8) {
+        byte b = src[i / 8];
+        memcpy(out + i, &nibbleStates[b & 0x0F], 4);
+        memcpy(out + i + 4, &nibbleStates[b >> 4], 4);
+    }
+#endif
+    for (; i < count; i++) { out[i] = (src[i / 8] >> (i % 8)) & 0x01; }
+}
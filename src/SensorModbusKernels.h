@@ -0,0 +1,59 @@
+/**
+ * @file SensorModbusKernels.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains bulk conversion functions for large blocks of register and coil
+ * data.
+ *
+ * Converting a whole block at once is much faster than converting it value by value
+ * with the frame functions.  On x86 processors these use SSE2 (or SSSE3, if enabled in
+ * the compiler flags), on ARM processors with NEON they use NEON, and everywhere else
+ * they fall back to plain C++ that works a word at a time where the processor allows.
+ *
+ * Like the rest of the library, these assume the processor is little endian.
+ */
+
+#ifndef SensorModbusKernels_h
+#define SensorModbusKernels_h
+
+#include "SensorModbusMaster.h"
+
+/**
+ * @brief Convert big endian 16-bit registers into native values
+ *
+ * This is the conversion for every uint16_t or int16_t register.  The source and
+ * destination may be the same buffer.
+ *
+ * @param src The register data, ie, the data bytes of a response
+ * @param dest The buffer for the values; it need not be aligned.
+ * @param count The number of registers
+ */
+void modbusSwap16(const byte* src, void* dest, uint16_t count);
+
+/**
+ * @brief Convert big endian 32-bit values into native values
+ *
+ * This is the conversion for uint32_t, int32_t, or float values stored big endian
+ * (most significant byte first) in pairs of registers.  Little endian values need no
+ * conversion and can be copied directly.  The source and destination may be the same
+ * buffer.
+ *
+ * @param src The register data, ie, the data bytes of a response
+ * @param dest The buffer for the values; it need not be aligned.
+ * @param count The number of 32-bit values
+ */
+void modbusSwap32(const byte* src, void* dest, uint16_t count);
+
+/**
+ * @brief Unpack coil or discrete input states into one byte per state
+ *
+ * @param src The packed states, ie, the data bytes of a response
+ * @param dest The buffer for the states; each is set to 1 (ON) or 0 (OFF).  A bool
+ * array can be used.
+ * @param count The number of states
+ */
+void modbusUnpackBits(const byte* src, void* dest, uint16_t count);
+
+#endif
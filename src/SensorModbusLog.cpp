@@ -0,0 +1,266 @@
+/**
+ * @file SensorModbusLog.cpp
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusBlockLogger and modbusLogReader class definitions.
+ */
+
+#include "SensorModbusLog.h"
+
+// The size of the header before the column descriptions
+#define LOG_HEADER_SIZE 8
+// The size of each column description
+#define LOG_COLUMN_SIZE 4
+
+
+//----------------------------------------------------------------------------
+//                                 LOG WRITER
+//----------------------------------------------------------------------------
+
+modbusBlockLogger::modbusBlockLogger(uint32_t* buffer, uint16_t bufferSize)
+    : _out(nullptr),
+      _columns(nullptr),
+      _numColumns(0),
+      _buffer(buffer),
+      _bufferSize(bufferSize),
+      _chunkRecords(0),
+      _pending(0),
+      _crc(0xFFFF),
+      _writeOK(false),
+      _bytesWritten(0),
+      _recordCount(0) {}
+
+bool modbusBlockLogger::begin(Print& out, const modbusLogColumn* columns,
+                              uint8_t numColumns) {
+    _columns      = columns;
+    _numColumns   = numColumns;
+    _chunkRecords = _bufferSize / (numColumns + 1);
+    _pending      = 0;
+    _bytesWritten = 0;
+    _recordCount  = 0;
+    _writeOK      = _chunkRecords > 0;
+    // Without room for a record, leave nothing to write to, so record() and flush()
+    // refuse instead of overrunning the buffer
+    _out = _writeOK ? &out : nullptr;
+    if (!_writeOK) { return false; }
+
+    _crc = 0xFFFF;
+    writeByte('M');
+    writeByte('B');
+    writeByte('L');
+    writeByte('G');
+    writeByte(MODBUS_LOG_VERSION);
+    writeByte(numColumns);
+    writeByte(lowByte(_chunkRecords));
+    writeByte(highByte(_chunkRecords));
+    for (uint8_t c = 0; c < numColumns; c++) {
+        writeByte(lowByte(columns[c].index));
+        writeByte(highByte(columns[c].index));
+        writeByte(static_cast<byte>(columns[c].type));
+        writeByte(static_cast<byte>(columns[c].endian));
+    }
+    writeCRC();
+    return _writeOK;
+}
+
+bool modbusBlockLogger::record(uint32_t timestamp, const modbusFrameView& block) {
+    if (_out == nullptr || !block.valid()) { return false; }
+
+    uint32_t* entry = _buffer + _pending * (_numColumns + 1);
+    entry[0]        = timestamp;
+    for (uint8_t c = 0; c < _numColumns; c++) {
+        const modbusLogColumn& column = _columns[c];
+        if (column.index + modbusFrameView::registersFor(column.type) >
+            block.registerCount()) {
+            return false;
+        }
+        uint32_t raw = block.rawAt(column.index, column.type, column.endian);
+        // Sign extend 16-bit integers so a change across 0 is a small difference
+        if (column.type == int16Value) {
+            int16_t value = static_cast<int16_t>(raw);
+            raw           = static_cast<uint32_t>(static_cast<int32_t>(value));
+        }
+        entry[c + 1] = raw;
+    }
+    _pending++;
+    _recordCount++;
+
+    if (_pending >= _chunkRecords) { return flush(); }
+    return _writeOK;
+}
+
+bool modbusBlockLogger::flush(void) {
+    if (_out == nullptr || _pending == 0) { return _writeOK; }
+
+    // The sync marker is not part of the CRC
+    uint32_t sync = MODBUS_LOG_SYNC;
+    for (uint8_t i = 0; i < 4; i++) {
+        writeByte(static_cast<byte>(sync));
+        sync >>= 8;
+    }
+    _crc = 0xFFFF;
+
+    // The record count, then every timestamp, then every value of each column
+    writeVarint(_pending);
+    // 255 columns is a stride of 256
+    uint16_t stride = _numColumns + 1;
+    for (uint16_t c = 0; c < stride; c++) {
+        uint32_t previous = 0;
+        for (uint16_t r = 0; r < _pending; r++) {
+            uint32_t value = _buffer[r * stride + c];
+            writeDelta(value, previous);
+            previous = value;
+        }
+    }
+    writeCRC();
+
+    _pending = 0;
+    return _writeOK;
+}
+
+void modbusBlockLogger::writeByte(byte value) {
+    if (_out->write(value) != 1) { _writeOK = false; }
+    _crc = modbusMaster::crcUpdate(_crc, value);
+    _bytesWritten++;
+}
+
+void modbusBlockLogger::writeDelta(uint32_t value, uint32_t previous) {
+    // Zigzag: 0, -1, 1, -2, 2 ... become 0, 1, 2, 3, 4 ...
+    int32_t  delta = static_cast<int32_t>(value - previous);
+    writeVarint((static_cast<uint32_t>(delta) << 1) ^
+                static_cast<uint32_t>(delta >> 31));
+}
+
+void modbusBlockLogger::writeVarint(uint32_t value) {
+    while (value >= 0x80) {
+        writeByte(static_cast<byte>(value | 0x80));
+        value >>= 7;
+    }
+    writeByte(static_cast<byte>(value));
+}
+
+void modbusBlockLogger::writeCRC(void) {
+    uint16_t crc = _crc;
+    writeByte(lowByte(crc));
+    writeByte(highByte(crc));
+}
+
+
+//----------------------------------------------------------------------------
+//                                 LOG READER
+//----------------------------------------------------------------------------
+
+modbusLogReader::modbusLogReader(const byte* data, size_t length)
+    : _data(data),
+      _length(length),
+      _pos(0),
+      _columnsAt(LOG_HEADER_SIZE),
+      _numColumns(0),
+      _chunkRecords(0),
+      _skipped(0) {}
+
+bool modbusLogReader::begin(void) {
+    _numColumns = 0;
+    if (_data == nullptr || _length < LOG_HEADER_SIZE + 2) { return false; }
+    if (_data[0] != 'M' || _data[1] != 'B' || _data[2] != 'L' || _data[3] != 'G' ||
+        _data[4] != MODBUS_LOG_VERSION) {
+        return false;
+    }
+    size_t headerSize = LOG_HEADER_SIZE + _data[5] * LOG_COLUMN_SIZE;
+    if (_length < headerSize + 2) { return false; }
+    uint16_t crc = modbusMaster::crc16(_data, headerSize);
+    if (_data[headerSize] != lowByte(crc) || _data[headerSize + 1] != highByte(crc)) {
+        return false;
+    }
+    _numColumns   = _data[5];
+    _chunkRecords = _data[6] | (_data[7] << 8);
+    _pos          = headerSize + 2;
+    _skipped      = 0;
+    return true;
+}
+
+modbusLogColumn modbusLogReader::getColumn(uint8_t column) const {
+    modbusLogColumn result = {0, uint16Value, bigEndian};
+    if (column >= _numColumns) { return result; }
+    const byte* desc = _data + _columnsAt + column * LOG_COLUMN_SIZE;
+    result.index     = desc[0] | (desc[1] << 8);
+    result.type      = static_cast<modbusDataType>(desc[2]);
+    result.endian    = static_cast<endianness>(desc[3]);
+    return result;
+}
+
+int32_t modbusLogReader::nextChunk(uint32_t* timestamps, leFrame* values,
+                                   uint16_t maxRecords) {
+    if (_numColumns == 0 && _pos == 0) { return 0; }
+    while (_pos + 4 <= _length) {
+        uint32_t marker = static_cast<uint32_t>(_data[_pos]) |
+            (static_cast<uint32_t>(_data[_pos + 1]) << 8) |
+            (static_cast<uint32_t>(_data[_pos + 2]) << 16) |
+            (static_cast<uint32_t>(_data[_pos + 3]) << 24);
+        if (marker == MODBUS_LOG_SYNC) {
+            size_t   end     = 0;
+            uint32_t records = decodeChunk(_pos, end, timestamps, values, maxRecords);
+            // A good chunk too big for the arrays is left to be read again
+            if (records > maxRecords) { return -static_cast<int32_t>(records); }
+            if (records > 0) {
+                _pos = end;
+                return static_cast<int32_t>(records);
+            }
+        }
+        // Not a good chunk; look for the next marker
+        _pos++;
+        _skipped++;
+    }
+    _skipped += _length - _pos;
+    _pos = _length;
+    return 0;
+}
+
+bool modbusLogReader::readVarint(size_t& pos, uint32_t& value) const {
+    value = 0;
+    for (uint8_t shift = 0; shift < 35 && pos < _length; shift += 7) {
+        byte b = _data[pos++];
+        value |= static_cast<uint32_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) { return true; }
+    }
+    return false;
+}
+
+uint32_t modbusLogReader::decodeChunk(size_t start, size_t& end, uint32_t* timestamps,
+                                      leFrame* values, uint16_t maxRecords) const {
+    size_t   pos = start + 4;
+    uint32_t records;
+    // A chunk can't hold more records than the logger's buffer did
+    if (!readVarint(pos, records) || records == 0 || records > _chunkRecords) {
+        return 0;
+    }
+    // Check a chunk too big for the arrays without storing it
+    bool store = records <= maxRecords;
+
+    for (uint16_t c = 0; c <= _numColumns; c++) {
+        uint32_t value = 0;
+        for (uint16_t r = 0; r < records; r++) {
+            uint32_t zz;
+            if (!readVarint(pos, zz)) { return 0; }
+            // Undo the zigzag, then add the difference to the previous value
+            value += (zz >> 1) ^ (0 - (zz & 1));
+            if (!store) { continue; }
+            if (c == 0) {
+                timestamps[r] = value;
+            } else {
+                values[(c - 1) * maxRecords + r].uInt32 = value;
+            }
+        }
+    }
+
+    if (pos + 2 > _length) { return 0; }
+    uint16_t crc = 0xFFFF;
+    for (size_t i = start + 4; i < pos; i++) {
+        crc = modbusMaster::crcUpdate(crc, _data[i]);
+    }
+    if (_data[pos] != lowByte(crc) || _data[pos + 1] != highByte(crc)) { return 0; }
+    end = pos + 2;
+    return records;
+}
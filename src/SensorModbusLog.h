@@ -0,0 +1,287 @@
+/**
+ * @file SensorModbusLog.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusBlockLogger and modbusLogReader class declarations.
+ *
+ * The log format is:
+ * - A header: the magic "MBLG", the format version (1), the number of columns, the most
+ * records in a chunk (2 bytes, little endian), then for each column its register index
+ * (2 bytes, little endian), modbusDataType, and endianness, and finally the modbus
+ * CRC of the header (2 bytes, low byte first).
+ * - Any number of chunks: the sync marker #MODBUS_LOG_SYNC, the number of records, the
+ * timestamps of the records, then the values of each column in turn, and finally the
+ * modbus CRC of everything after the sync marker.
+ *
+ * Within a chunk, each timestamp and value is stored as the difference from the one
+ * before it in the same column (the first from 0), zigzag encoded so small negative
+ * differences stay small, and written as a variable length integer: 7 bits to a byte,
+ * least significant first, with the high bit set on every byte but the last.  A value
+ * that does not change takes a single byte.  Every chunk can be decoded on its own, so
+ * a damaged chunk only loses its own records.
+ */
+
+#ifndef SensorModbusLog_h
+#define SensorModbusLog_h
+
+#include "SensorModbusMaster.h"
+
+/**
+ * @brief The version of the log format written
+ */
+#define MODBUS_LOG_VERSION 1
+/**
+ * @brief The marker at the start of each chunk of a log, as a little endian uint32_t
+ */
+#define MODBUS_LOG_SYNC 0x3CC35AA5UL
+
+/**
+ * @brief One column of a log: where a value is in each register block and how it is
+ * stored.
+ */
+typedef struct modbusLogColumn {
+    uint16_t       index;   ///< The index of the first register of the value in a block
+    modbusDataType type;    ///< The type of the value
+    endianness     endian;  ///< The endianness of the value
+} modbusLogColumn;
+
+/**
+ * @brief Writes register blocks to a compact binary log.
+ *
+ * Records are gathered in a buffer you supply and written a chunk at a time, column by
+ * column, so a value that changes slowly costs about one byte per record instead of a
+ * formatted line of text.  Only the raw register values are logged; nothing is
+ * converted or formatted on the logger.
+ *
+ * @code{.cpp}
+ * modbusLogColumn   columns[] = {{0, float32Value, bigEndian},
+ *                                {2, uint16Value, bigEndian}};
+ * uint32_t          logBuffer[48];  // 16 records of a timestamp and 2 columns
+ * modbusBlockLogger logger(logBuffer, 48);
+ *
+ * logger.begin(file, columns, 2);
+ * logger.record(millis(), modbus.getRegisterView(0x03, 100, 3));
+ * ...
+ * logger.flush();
+ * @endcode
+ */
+class modbusBlockLogger {
+ public:
+    /**
+     * @brief Construct a new modbus Block Logger object
+     *
+     * @param buffer The buffer to gather records in; each record takes one entry for
+     * its timestamp and one for each column.
+     * @param bufferSize The number of entries in the buffer
+     */
+    modbusBlockLogger(uint32_t* buffer, uint16_t bufferSize);
+
+    /**
+     * @brief Start a log and write its header
+     *
+     * @param out The stream or file to write the log to.
+     * @param columns The columns to log.  The array must stay unchanged for as long as
+     * the logger is used.
+     * @param numColumns The number of columns.
+     * @return True if the header was written; false if the buffer cannot hold a
+     * single record or the write failed.
+     */
+    bool begin(Print& out, const modbusLogColumn* columns, uint8_t numColumns);
+
+    /**
+     * @brief Add a record to the log
+     *
+     * A chunk is written each time the buffer fills.
+     *
+     * @param timestamp The time of the record, in any unit.
+     * @param block The register block to take the column values from.
+     * @return True if the record was added; false if begin() failed or was not
+     * called, the block is not valid, or writing a chunk failed.
+     */
+    bool record(uint32_t timestamp, const modbusFrameView& block);
+    /**
+     * @brief Add a record to the log
+     *
+     * @param timestamp The time of the record, in any unit.
+     * @param data The register block to take the column values from.
+     * @param size The number of bytes in the block.
+     * @return True if the record was added.
+     */
+    bool record(uint32_t timestamp, const byte* data, uint16_t size) {
+        return record(timestamp, modbusFrameView(data, size));
+    }
+
+    /**
+     * @brief Write any records waiting in the buffer as a (short) chunk
+     *
+     * Call this before closing the file or powering down.
+     *
+     * @return True if the chunk was written, or there was nothing to write.
+     */
+    bool flush(void);
+
+    /**
+     * @brief Get the number of bytes written to the log
+     *
+     * @return The number of bytes written.
+     */
+    uint32_t getBytesWritten() const {
+        return _bytesWritten;
+    }
+    /**
+     * @brief Get the number of records written or waiting to be written
+     *
+     * @return The number of records.
+     */
+    uint32_t getRecordCount() const {
+        return _recordCount;
+    }
+
+ private:
+    /**
+     * @brief Write one byte, adding it to the CRC
+     *
+     * @param value The byte
+     */
+    void writeByte(byte value);
+    /**
+     * @brief Write a variable length integer
+     *
+     * @param value The integer
+     */
+    void writeVarint(uint32_t value);
+    /**
+     * @brief Write the difference between two values as a zigzag variable length
+     * integer
+     *
+     * @param value The value
+     * @param previous The value before it
+     */
+    void writeDelta(uint32_t value, uint32_t previous);
+    /**
+     * @brief Write the modbus CRC of the bytes written since it was reset
+     */
+    void writeCRC(void);
+
+    Print*                 _out;           ///< The log stream
+    const modbusLogColumn* _columns;       ///< The columns
+    uint8_t                _numColumns;    ///< The number of columns
+    uint32_t*              _buffer;        ///< The gathered records
+    uint16_t               _bufferSize;    ///< The number of entries in the buffer
+    uint16_t               _chunkRecords;  ///< The most records in a chunk
+    uint16_t               _pending;       ///< The records waiting in the buffer
+    uint16_t               _crc;           ///< The running CRC of the chunk
+    bool                   _writeOK;       ///< False once a write has failed
+    uint32_t               _bytesWritten;  ///< The bytes written
+    uint32_t               _recordCount;   ///< The records added
+};
+
+/**
+ * @brief Reads a log written by a modbusBlockLogger back into columns.
+ *
+ * The reader works on a log already in memory, ie, a file read off an SD card on a
+ * computer.  Each chunk is expanded into an array of timestamps and a column-major
+ * array of leFrame values; use the member of each leFrame that matches the column's
+ * type (uInt16[0], Int16[0], uInt32, Int32, or Float32).  A chunk with a bad CRC is
+ * skipped and the reader moves on to the next sync marker.
+ */
+class modbusLogReader {
+ public:
+    /**
+     * @brief Construct a new modbus Log Reader object
+     *
+     * @param data The log
+     * @param length The length of the log in bytes
+     */
+    modbusLogReader(const byte* data, size_t length);
+
+    /**
+     * @brief Read the header of the log
+     *
+     * @return True if the log has a valid header of a version this reader knows.
+     */
+    bool begin(void);
+    /**
+     * @brief Get the number of columns in the log
+     *
+     * @return The number of columns.
+     */
+    uint8_t getColumnCount() const {
+        return _numColumns;
+    }
+    /**
+     * @brief Get the description of a column
+     *
+     * @param column The index of the column
+     * @return The column description.
+     */
+    modbusLogColumn getColumn(uint8_t column) const;
+    /**
+     * @brief Get the most records in one chunk of the log; the arrays given to
+     * nextChunk() must hold this many.
+     *
+     * @return The most records in a chunk.
+     */
+    uint16_t getChunkRecords() const {
+        return _chunkRecords;
+    }
+
+    /**
+     * @brief Decode the next good chunk of the log
+     *
+     * @param timestamps The array for the timestamps of the records.
+     * @param values The array for the values, column by column: the value of column c
+     * in record r goes in values[c * maxRecords + r].
+     * @param maxRecords The number of records the arrays can hold; arrays that hold
+     * getChunkRecords() records can hold any chunk.
+     * @return The number of records decoded; 0 at the end of the log.  If the next
+     * good chunk holds more than maxRecords records, this is minus the number it holds,
+     * and the chunk is left to be read again with larger arrays.
+     */
+    int32_t nextChunk(uint32_t* timestamps, leFrame* values, uint16_t maxRecords);
+
+    /**
+     * @brief Get the number of bytes skipped because they were not part of a good
+     * chunk
+     *
+     * @return The number of bytes skipped.
+     */
+    uint32_t getSkippedBytes() const {
+        return _skipped;
+    }
+
+ private:
+    /**
+     * @brief Read a variable length integer
+     *
+     * @param pos The position to read at; moved past the integer
+     * @param value The integer read
+     * @return True if a whole integer was read.
+     */
+    bool readVarint(size_t& pos, uint32_t& value) const;
+    /**
+     * @brief Decode the chunk whose sync marker is at a position
+     *
+     * @param start The position of the sync marker
+     * @param end The position just past the chunk, if it is good
+     * @param timestamps The array for the timestamps
+     * @param values The array for the values
+     * @param maxRecords The number of records the arrays can hold
+     * @return The number of records in the chunk; 0 if the chunk is bad.  If this is
+     * more than maxRecords, the chunk is good but nothing was stored.
+     */
+    uint32_t decodeChunk(size_t start, size_t& end, uint32_t* timestamps,
+                         leFrame* values, uint16_t maxRecords) const;
+
+    const byte* _data;          ///< The log
+    size_t      _length;        ///< The length of the log
+    size_t      _pos;           ///< The position of the next chunk to look for
+    size_t      _columnsAt;     ///< The position of the column descriptions
+    uint8_t     _numColumns;    ///< The number of columns
+    uint16_t    _chunkRecords;  ///< The most records in a chunk
+    uint32_t    _skipped;       ///< The bytes skipped
+};
+
+#endif
@@ -20,6 +20,11 @@ byte modbusMaster::commandBuffer[COMMAND_BUFFER_SIZE] = {
 byte modbusMaster::crcFrame[2] = {
     0x00,
 };
+// initialize the circuit breaker health table
+slaveHealth modbusMaster::healthTable[MODBUS_HEALTH_TABLE_SIZE] = {};
+// initialize the device identification cache
+modbusDeviceInfo modbusMaster::deviceCache[MODBUS_DEVICE_CACHE_SIZE] = {};
+uint8_t          modbusMaster::nextDeviceCacheEntry                  = 0;
 
 
 //----------------------------------------------------------------------------
@@ -107,6 +112,44 @@ int8_t modbusMaster::getEnablePin() {
     return _enablePin;
 }
 
+void modbusMaster::setBaudRate(uint32_t baudRate) {
+    _baudRate = baudRate;
+}
+uint32_t modbusMaster::getBaudRate() {
+    return _baudRate;
+}
+
+void modbusMaster::setDriverTiming(uint16_t settleMicros, uint16_t holdMicros) {
+    _driverSettle = settleMicros;
+    _driverHold   = holdMicros;
+}
+
+void modbusMaster::setEchoSuppression(bool enable) {
+    _echoSuppression = enable;
+}
+bool modbusMaster::getEchoSuppression() {
+    return _echoSuppression;
+}
+uint32_t modbusMaster::getBusCollisionCount() {
+    return _busCollisions;
+}
+void modbusMaster::resetBusCollisionCount() {
+    _busCollisions = 0;
+}
+
+void modbusMaster::setFrameRecovery(bool enable) {
+    _frameRecovery = enable;
+}
+bool modbusMaster::getFrameRecovery() {
+    return _frameRecovery;
+}
+uint32_t modbusMaster::getRecoveredFrameCount() {
+    return _recoveredFrames;
+}
+void modbusMaster::resetRecoveredFrameCount() {
+    _recoveredFrames = 0;
+}
+
 void modbusMaster::setCommandTimeout(uint32_t timeout) {
     modbusTimeout = timeout;
 }
@@ -141,6 +184,27 @@ Stream* modbusMaster::getStream() {
     return _stream;
 }
 
+void modbusMaster::setCircuitBreaker(uint8_t failureThreshold, uint32_t backoff,
+                                     uint32_t maxBackoff) {
+    circuitThreshold  = failureThreshold;
+    circuitBackoff    = backoff;
+    circuitMaxBackoff = maxBackoff < backoff ? backoff : maxBackoff;
+}
+uint8_t modbusMaster::getCircuitBreakerThreshold() {
+    return circuitThreshold;
+}
+circuitState modbusMaster::getCircuitState(byte slaveID) {
+    slaveHealth* health = findSlaveHealth(slaveID);
+    if (health == nullptr) { return circuitClosed; }
+    return health->state;
+}
+void modbusMaster::resetCircuit(byte slaveID) {
+    slaveHealth* health = findSlaveHealth(slaveID);
+    if (health == nullptr) { return; }
+    changeCircuitState(health, circuitClosed);
+    health->stream = nullptr;
+}
+
 
 //----------------------------------------------------------------------------
 //                           HIGHEST LEVEL FUNCTIONS
@@ -199,10 +263,21 @@ int8_t modbusMaster::pointerTypeFromRegister(byte regType, int regNum,
     getModbusData(_slaveID, regType, regNum, POINTER_SIZE / 2);
     return pointerTypeFromFrame(endian);
 }
+#ifndef MODBUSMASTER_NO_STRING
 String modbusMaster::StringFromRegister(byte regType, int regNum, int charLength) {
     getModbusData(_slaveID, regType, regNum, charLength / 2);
     return StringFromFrame(charLength);
 }
+#endif  // MODBUSMASTER_NO_STRING
+uint16_t modbusMaster::textFromRegister(byte regType, int regNum, int charLength,
+                                        char* buffer, uint16_t bufferSize,
+                                        bool trim) {
+    if (getModbusData(_slaveID, regType, regNum, (charLength + 1) / 2) == 0) {
+        if (buffer != nullptr && bufferSize > 0) { buffer[0] = '\0'; }
+        return 0;
+    }
+    return textFromFrame(charLength, buffer, bufferSize, trim);
+}
 void modbusMaster::charFromRegister(byte regType, int regNum, char* outChar,
                                     int charLength) {
     getModbusData(_slaveID, regType, regNum, charLength / 2);
@@ -286,9 +361,27 @@ bool modbusMaster::pointerToRegister(int regNum, uint16_t value, pointerType poi
     pointerToFrame(value, point, endian, bytesToWrite, 0);
     return setRegisters(regNum, UINT16_SIZE / 2, bytesToWrite, forceMultiple);
 }
-bool modbusMaster::StringToRegister(int regNum, String value, bool forceMultiple) {
-    return setRegisters(regNum, value.length() / 2, (uint8_t*)value.c_str(),
-                        forceMultiple);
+#ifndef MODBUSMASTER_NO_STRING
+bool modbusMaster::StringToRegister(int regNum, const String& value,
+                                    bool forceMultiple) {
+    return textToRegister(regNum, value.c_str(), value.length(), forceMultiple);
+}
+#endif  // MODBUSMASTER_NO_STRING
+bool modbusMaster::textToRegister(int regNum, const char* text, int charLength,
+                                  bool forceMultiple) {
+    int numRegisters = (charLength + 1) / 2;
+    if (text == nullptr || numRegisters < 1 ||
+        numRegisters * 2 > RESPONSE_BUFFER_SIZE) {
+        lastError = ILLEGAL_DATA_VALUE;
+        return false;
+    }
+    // Build the padded field in the response buffer; setRegisters copies it into the
+    // command buffer before anything is sent or received
+    memset(responseBuffer, '\0', numRegisters * 2);
+    for (int i = 0; i < charLength && text[i] != '\0'; i++) {
+        responseBuffer[i] = text[i];
+    }
+    return setRegisters(regNum, numRegisters, responseBuffer, forceMultiple);
 }
 bool modbusMaster::charToRegister(int regNum, char* inChar, int charLength,
                                   bool forceMultiple) {
@@ -329,8 +422,6 @@ int16_t modbusMaster::getRegisters(byte readCommand, int16_t startRegister,
     // copy from the raw responseBuffer, starting at character 3 (the first two are the
     // returned bytes)
     memcpy(buff, responseBuffer + 3, numRegisters * 2);
-    // null terminate the buffer
-    memset(buff, '\0', numRegisters * 2);
     return rxBytes;
 }
 
@@ -342,9 +433,7 @@ int16_t modbusMaster::getCoils(int16_t startCoil, int16_t numCoils, byte* buff)
     if (buff == responseBuffer) { return rxBytes; }
     // copy from the raw responseBuffer, starting at character 3 (the first two are the
     // returned bytes)
-    memcpy(buff, responseBuffer + 3, ceil(numCoils / 8));
-    // null terminate the buffer
-    memset(buff, '\0', ceil(numCoils / 8));
+    memcpy(buff, responseBuffer + 3, (numCoils + 7) / 8);
     return rxBytes;
 }
 
@@ -357,12 +446,31 @@ int16_t modbusMaster::getDiscreteInputs(int16_t startInput, int16_t numInputs,
     if (buff == responseBuffer) { return rxBytes; }
     // copy from the raw responseBuffer, starting at character 3 (the first two are the
     // returned bytes)
-    memcpy(buff, responseBuffer + 3, ceil(numInputs / 8));
-    // null terminate the buffer
-    memset(buff, '\0', ceil(numInputs / 8));
+    memcpy(buff, responseBuffer + 3, (numInputs + 7) / 8);
     return rxBytes;
 }
 
+// These read data and return a view of it in the response buffer instead of copying
+modbusFrameView modbusMaster::getRegisterView(byte readCommand, int16_t startRegister,
+                                              int16_t numRegisters) {
+    int16_t rxBytes = getModbusData(_slaveID, readCommand, startRegister, numRegisters);
+    if (rxBytes == 0) { return modbusFrameView(); }
+    return modbusFrameView(responseBuffer + 3, rxBytes, _timing);
+}
+
+modbusFrameView modbusMaster::getCoilView(int16_t startCoil, int16_t numCoils) {
+    int16_t rxBytes = getModbusData(_slaveID, 0x01, startCoil, numCoils);
+    if (rxBytes == 0) { return modbusFrameView(); }
+    return modbusFrameView(responseBuffer + 3, rxBytes, _timing);
+}
+
+modbusFrameView modbusMaster::getDiscreteInputView(int16_t startInput,
+                                                   int16_t numInputs) {
+    int16_t rxBytes = getModbusData(_slaveID, 0x02, startInput, numInputs);
+    if (rxBytes == 0) { return modbusFrameView(); }
+    return modbusFrameView(responseBuffer + 3, rxBytes, _timing);
+}
+
 //----------------------------------------------------------------------------
 //                           MID LEVEL FUNCTIONS
 //----------------------------------------------------------------------------
@@ -444,22 +552,35 @@ int8_t modbusMaster::pointerTypeFromFrame(endianness endian, int start_index,
     return pointerRegType;
 }
 
+#ifndef MODBUSMASTER_NO_STRING
 String modbusMaster::StringFromFrame(int charLength, int start_index,
                                      byte* sourceFrame) {
     char charString[RESPONSE_BUFFER_SIZE];
-    memset(charString, '\0', RESPONSE_BUFFER_SIZE);
+    textFromFrame(charLength, charString, RESPONSE_BUFFER_SIZE, false, start_index,
+                  sourceFrame);
+    return String(charString);
+}
+#endif  // MODBUSMASTER_NO_STRING
+
+uint16_t modbusMaster::textFromFrame(int charLength, char* buffer,
+                                     uint16_t bufferSize, bool trim, int start_index,
+                                     byte* sourceFrame) {
+    if (buffer == nullptr || bufferSize == 0) { return 0; }
     printArraySlice(sourceFrame, start_index, charLength);
-    int j = 0;
-    for (int i = start_index; i < start_index + charLength; i++) {
+    uint16_t j = 0;
+    for (int i = start_index; i < start_index + charLength && j < bufferSize - 1;
+         i++) {
         // check that it's a printable character
-        if (sourceFrame[i] >= 0x20 && sourceFrame[i] <= 0x7E) {
-            // implicitly converts from "byte" type to "char" type
-            charString[j] = sourceFrame[i];
-            j++;
-        }
+        if (sourceFrame[i] < 0x20 || sourceFrame[i] > 0x7E) { continue; }
+        // skip leading spaces if trimming
+        if (trim && j == 0 && sourceFrame[i] == ' ') { continue; }
+        buffer[j++] = sourceFrame[i];
     }
-    String string = String(charString);
-    return string;
+    // drop trailing spaces if trimming
+    while (trim && j > 0 && buffer[j - 1] == ' ') { j--; }
+    // null terminate the string
+    buffer[j] = '\0';
+    return j;
 }
 
 void modbusMaster::charFromFrame(char* outChar, int charLength, int start_index,
@@ -475,7 +596,7 @@ void modbusMaster::charFromFrame(char* outChar, int charLength, int start_index,
         }
     }
     if (j < charLength) {
-        for (int i = j; i < +charLength; i++) { outChar[j] = '\0'; }
+        for (int i = j; i < charLength; i++) { outChar[i] = '\0'; }
     }
     // null terminate the string
     outChar[charLength] = '\0';
@@ -637,9 +758,12 @@ void modbusMaster::pointerToFrame(uint16_t value, pointerType point, endianness
         destFrame[start_index + 1] = fram.Byte[1];
     }
 }
-void modbusMaster::StringToFrame(String value, byte* destFrame, int start_index) {
+#ifndef MODBUSMASTER_NO_STRING
+void modbusMaster::StringToFrame(const String& value, byte* destFrame,
+                                 int start_index) {
     memcpy(destFrame + start_index, value.c_str(), value.length());
 }
+#endif  // MODBUSMASTER_NO_STRING
 void modbusMaster::charToFrame(char* inChar, int charLength, byte* destFrame,
                                int start_index) {
     memcpy(destFrame + start_index, inChar, charLength);
@@ -658,24 +782,25 @@ void modbusMaster::charToFrame(const char* inChar, int charLength, byte* destFra
 int16_t modbusMaster::getModbusData(byte slaveId, byte readCommand,
                                     int16_t startAddress, int16_t numChunks,
                                     uint8_t expectedReturnBytes) {
-    // Empty the command buffer, just in case
-    memset(commandBuffer, 0x00, COMMAND_BUFFER_SIZE);
-    // Put in the slave id and the command number into the command buffer
+    // Don't send a read that's larger than the slave may answer or than will fit in
+    // the response buffer
+    uint16_t maxChunks = maxReadChunks(readCommand);
+    if (expectedReturnBytes == 0 && maxChunks > 0 &&
+        (numChunks < 1 || numChunks > static_cast<int16_t>(maxChunks))) {
+        debugPrint(F("Cannot read "), numChunks, F(" values at once; the limit is "),
+                   maxChunks, '\n');
+        lastError = ILLEGAL_DATA_VALUE;
+        return 0;
+    }
+
+    // Put in the slave id, the command number, the starting register, and the number
+    // of registers; only these 6 bytes and the CRC are sent
     commandBuffer[0] = slaveId;
     commandBuffer[1] = readCommand;
-
-    // Put in the starting register
-    leFrame fram     = {{
-        0,
-    }};
-    fram.Int16[0]    = startAddress;
-    commandBuffer[2] = fram.Byte[1];
-    commandBuffer[3] = fram.Byte[0];
-
-    // Put in the number of registers
-    fram.Int16[1]    = numChunks;
-    commandBuffer[4] = fram.Byte[3];
-    commandBuffer[5] = fram.Byte[2];
+    commandBuffer[2] = highByte(startAddress);
+    commandBuffer[3] = lowByte(startAddress);
+    commandBuffer[4] = highByte(numChunks);
+    commandBuffer[5] = lowByte(numChunks);
 
     // The size of the returned frame should be:
     // # Registers X 1 bit or 2 bytes/register + 5 bytes of modbus RTU frame
@@ -683,7 +808,7 @@ int16_t modbusMaster::getModbusData(byte slaveId, byte readCommand,
         switch (readCommand) {
             case 0x01:  // Coils
             case 0x02:  // Discrete Inputs
-                expectedReturnBytes = ceil(numChunks / 8.0);
+                expectedReturnBytes = (numChunks + 7) / 8;
                 break;
             case 0x03:  // Holding Registers
             case 0x04:  // Input Registers
@@ -694,15 +819,36 @@ int16_t modbusMaster::getModbusData(byte slaveId, byte readCommand,
                 return false;
         }
     }
+
+    // The frame is the same on every try, so add the CRC once
+    insertCRC(commandBuffer, 8);
+    return readFrame(commandBuffer, expectedReturnBytes);
+}
+
+int16_t modbusMaster::getModbusData(const modbusPreparedRequest& request) {
+    if (!request.valid()) {
+        lastError = ILLEGAL_DATA_VALUE;
+        return 0;
+    }
+    return readFrame(request.frame(), request.expectedBytes());
+}
+
+modbusFrameView modbusMaster::getPreparedView(const modbusPreparedRequest& request) {
+    int16_t rxBytes = getModbusData(request);
+    if (rxBytes == 0) { return modbusFrameView(); }
+    return modbusFrameView(responseBuffer + 3, rxBytes, _timing);
+}
+
+int16_t modbusMaster::readFrame(const byte* frame, uint8_t expectedReturnBytes) {
     uint8_t returnFrameSize = expectedReturnBytes + 5;
 
     // Try up to commandRetries times to get the right results
     int  tries   = 0;
     bool success = false;
     while (!success && tries < commandRetries) {
-        // Send out the command - this adds the CRC and verifies that the return is from
-        // the right slave and has the correct CRC
-        int16_t respSize = sendCommand(commandBuffer, 8);
+        // Send out the command - this verifies that the return is from the right
+        // slave and has the correct CRC
+        int16_t respSize = sendFrame(frame, 8);
         // if we got a valid modbusErrorCode, stop trying
         // the sendCommand function will print the error info if debugging is on
         if (static_cast<int8_t>(lastError) > 0 &&
@@ -725,7 +871,7 @@ int16_t modbusMaster::getModbusData(byte slaveId, byte readCommand,
             debugPrint(F("  The slave said it is returning "), responseBuffer[2],
                        F(" bytes of expected "), expectedReturnBytes, '\n');
 
-            delay(25);
+            MODBUS_DELAY(25);
         }
         tries++;
     }
@@ -740,6 +886,16 @@ int16_t modbusMaster::getModbusData(byte slaveId, byte readCommand,
 // preset multiple registers) instead of using 0x06 for a single register
 bool modbusMaster::setRegisters(int16_t startRegister, int16_t numRegisters,
                                 byte* value, bool forceMultiple) {
+    // Don't send a write that's larger than the slave may accept or than will fit in
+    // the command buffer
+    if (numRegisters < 1 ||
+        numRegisters > static_cast<int16_t>(maxWriteChunks(0x10))) {
+        debugPrint(F("Cannot set "), numRegisters,
+                   F(" registers at once; the limit is "), maxWriteChunks(0x10), '\n');
+        lastError = ILLEGAL_DATA_VALUE;
+        return false;
+    }
+
     // figure out how long the command will be
     int commandLength;
     if (numRegisters > 1 || forceMultiple) {
@@ -851,7 +1007,7 @@ bool modbusMaster::setRegisters(int16_t startRegister, int16_t numRegisters,
                            responseBuffer[4], responseBuffer[5], F(" when "), value[0],
                            value[1], F(" was expected"), '\n');
             }
-            delay(25);
+            MODBUS_DELAY(25);
         }
         tries++;
     }
@@ -921,7 +1077,7 @@ bool modbusMaster::setCoil(int16_t coilAddress, bool value) {
                            ? F("does ")
                            : F("does not "),
                        F("match the command\n"));
-            delay(25);
+            MODBUS_DELAY(25);
         }
         tries++;
     }
@@ -930,6 +1086,15 @@ bool modbusMaster::setCoil(int16_t coilAddress, bool value) {
 }
 
 bool modbusMaster::setCoils(int16_t startCoil, int16_t numCoils, byte* value) {
+    // Don't send a write that's larger than the slave may accept or than will fit in
+    // the command buffer
+    if (numCoils < 1 || numCoils > static_cast<int16_t>(maxWriteChunks(0x0F))) {
+        debugPrint(F("Cannot set "), numCoils, F(" coils at once; the limit is "),
+                   maxWriteChunks(0x0F), '\n');
+        lastError = ILLEGAL_DATA_VALUE;
+        return false;
+    }
+
     // figure out how long the command will be
     // The full command for writing multiple coils has:
     // - slave address (1 byte)
@@ -1000,7 +1165,7 @@ bool modbusMaster::setCoils(int16_t startCoil, int16_t numCoils, byte* value) {
                        int16FromFrame(bigEndian, 2), F(" of expected "), startCoil);
             debugPrint(F("The slave said it set "), int16FromFrame(bigEndian, 4),
                        F(" of expected "), numCoils, F(" coils\n"));
-            delay(25);
+            MODBUS_DELAY(25);
         }
         tries++;
     }
@@ -1009,14 +1174,355 @@ bool modbusMaster::setCoils(int16_t startCoil, int16_t numCoils, byte* value) {
 }
 
 
+//----------------------------------------------------------------------------
+//                           BLOCK TRANSFER FUNCTIONS
+//----------------------------------------------------------------------------
+
+uint16_t modbusMaster::getRegisterBlock(byte readCommand, uint16_t startRegister,
+                                        uint16_t numRegisters, byte* buff) {
+    if (readCommand != 0x03 && readCommand != 0x04) {
+        debugPrint(F("Command "), readCommand, F(" does not read registers\n"));
+        lastError = ILLEGAL_FUNCTION;
+        return 0;
+    }
+    return getDataBlock(readCommand, startRegister, numRegisters, buff);
+}
+
+uint16_t modbusMaster::getCoilBlock(uint16_t startCoil, uint16_t numCoils,
+                                    byte* buff) {
+    return getDataBlock(0x01, startCoil, numCoils, buff);
+}
+
+uint16_t modbusMaster::getDiscreteInputBlock(uint16_t startInput, uint16_t numInputs,
+                                             byte* buff) {
+    return getDataBlock(0x02, startInput, numInputs, buff);
+}
+
+uint16_t modbusMaster::setRegisterBlock(uint16_t startRegister, uint16_t numRegisters,
+                                        byte* value, bool forceMultiple) {
+    uint16_t maxChunks = maxWriteChunks(0x10);
+    uint16_t numSet    = 0;
+    lastError          = NO_ERROR;
+    // Don't wrap around past the last address
+    if (static_cast<uint32_t>(startRegister) + numRegisters > 0x10000UL) {
+        numRegisters = static_cast<uint16_t>(0x10000UL - startRegister);
+    }
+    while (numSet < numRegisters) {
+        uint16_t chunk = numRegisters - numSet < maxChunks ? numRegisters - numSet
+                                                            : maxChunks;
+        if (!setRegisters(static_cast<int16_t>(startRegister + numSet),
+                          static_cast<int16_t>(chunk), value + numSet * 2,
+                          forceMultiple)) {
+            debugPrint(F("Block write stopped after "), numSet, F(" of "),
+                       numRegisters, F(" registers\n"));
+            break;
+        }
+        numSet += chunk;
+    }
+    return numSet;
+}
+
+uint16_t modbusMaster::setCoilBlock(uint16_t startCoil, uint16_t numCoils,
+                                    byte* value) {
+    // The most coils that can be written at once is always a multiple of 8, so every
+    // request starts on a byte boundary of the packed input
+    uint16_t maxChunks = maxWriteChunks(0x0F);
+    uint16_t numSet    = 0;
+    lastError          = NO_ERROR;
+    // Don't wrap around past the last address
+    if (static_cast<uint32_t>(startCoil) + numCoils > 0x10000UL) {
+        numCoils = static_cast<uint16_t>(0x10000UL - startCoil);
+    }
+    while (numSet < numCoils) {
+        uint16_t chunk = numCoils - numSet < maxChunks ? numCoils - numSet : maxChunks;
+        if (!setCoils(static_cast<int16_t>(startCoil + numSet),
+                      static_cast<int16_t>(chunk), value + numSet / 8)) {
+            debugPrint(F("Block write stopped after "), numSet, F(" of "), numCoils,
+                       F(" coils\n"));
+            break;
+        }
+        numSet += chunk;
+    }
+    return numSet;
+}
+
+
+uint16_t modbusMaster::streamRegisters(byte readCommand, uint16_t startRegister,
+                                       uint16_t numRegisters,
+                                       modbusElementHandler& handler,
+                                       uint8_t elementBytes, endianness endian) {
+    uint16_t regsPerElement = elementBytes / 2;
+    lastError               = NO_ERROR;
+    if ((readCommand != 0x03 && readCommand != 0x04) ||
+        (elementBytes != 2 && elementBytes != 4) ||
+        numRegisters % regsPerElement != 0) {
+        debugPrint(F("Cannot stream "), numRegisters, F(" registers as "),
+                   elementBytes, F(" byte values with command "), readCommand, '\n');
+        lastError = ILLEGAL_DATA_VALUE;
+        return 0;
+    }
+    // Don't wrap around past the last address
+    if (static_cast<uint32_t>(startRegister) + numRegisters > 0x10000UL) {
+        numRegisters = static_cast<uint16_t>(0x10000UL - startRegister);
+        numRegisters -= numRegisters % regsPerElement;
+    }
+    // Never split a value across two requests
+    uint16_t maxChunks = maxReadChunks(readCommand);
+    maxChunks -= maxChunks % regsPerElement;
+
+    _streamHandler      = &handler;
+    _streamElementBytes = elementBytes;
+    _streamEndian       = endian;
+    _streamPending      = 0;
+    uint16_t numRead    = 0;
+    while (numRead < numRegisters) {
+        uint16_t chunk = numRegisters - numRead < maxChunks ? numRegisters - numRead
+                                                            : maxChunks;
+        _streamExpectedBytes = chunk * 2;
+        _streamFirstElement  = numRead / regsPerElement;
+        if (getModbusData(_slaveID, readCommand,
+                          static_cast<int16_t>(startRegister + numRead),
+                          static_cast<int16_t>(chunk)) == 0) {
+            debugPrint(F("Streaming read stopped after "), numRead, F(" of "),
+                       numRegisters, F(" registers\n"));
+            break;
+        }
+        numRead += chunk;
+    }
+    _streamHandler = nullptr;
+    return numRead;
+}
+
+
+//----------------------------------------------------------------------------
+//                           DEVICE DISCOVERY FUNCTIONS
+//----------------------------------------------------------------------------
+
+void modbusMaster::setDiscoveryTimeout(uint32_t timeout) {
+    discoveryTimeout = timeout;
+}
+uint32_t modbusMaster::getDiscoveryTimeout() {
+    return discoveryTimeout;
+}
+
+bool modbusMaster::probeSlave(byte slaveID) {
+    // Use the short discovery timeout and keep the circuit breaker out of the way
+    uint32_t oldTimeout   = modbusTimeout;
+    uint8_t  oldThreshold = circuitThreshold;
+    modbusTimeout         = discoveryTimeout;
+    circuitThreshold      = 0;
+
+    requestServerID(slaveID);
+
+    modbusTimeout    = oldTimeout;
+    circuitThreshold = oldThreshold;
+    // Any correctly addressed answer with a good CRC - even an exception - means the
+    // slave is there
+    return lastError == NO_ERROR ||
+        (static_cast<int8_t>(lastError) > 0 && static_cast<int8_t>(lastError) < 0x0C);
+}
+
+uint8_t modbusMaster::discoverSlaves(byte firstID, byte lastID,
+                                     discoveryCallback callback) {
+    uint8_t found = 0;
+    // Use a 16-bit counter so a last ID of 255 doesn't loop forever
+    for (uint16_t slaveID = firstID; slaveID <= lastID; slaveID++) {
+        // Slave ID 0 is the broadcast address and never answers
+        if (slaveID == 0 || !probeSlave(slaveID)) { continue; }
+        debugPrint(F("Found modbus slave "), slaveID, '\n');
+        found++;
+
+        uint32_t oldTimeout   = modbusTimeout;
+        uint8_t  oldThreshold = circuitThreshold;
+        modbusTimeout         = discoveryTimeout;
+        circuitThreshold      = 0;
+        requestDeviceIdentification(slaveID);
+        modbusTimeout    = oldTimeout;
+        circuitThreshold = oldThreshold;
+
+        // Make sure there's a cache entry even if the slave supports neither function
+        modbusDeviceInfo* info = findDeviceInfo(slaveID, true);
+        if (callback != nullptr) { callback(*info); }
+    }
+    return found;
+}
+
+bool modbusMaster::reportServerID(byte slaveID) {
+    for (uint8_t tries = 0; tries < commandRetries; tries++) {
+        if (requestServerID(slaveID)) { return true; }
+        // If we got a valid modbusErrorCode, stop trying
+        if (static_cast<int8_t>(lastError) > 0 &&
+            static_cast<int8_t>(lastError) < 0x0C) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool modbusMaster::readDeviceIdentification(byte slaveID) {
+    for (uint8_t tries = 0; tries < commandRetries; tries++) {
+        if (requestDeviceIdentification(slaveID)) { return true; }
+        // If we got a valid modbusErrorCode, stop trying
+        if (static_cast<int8_t>(lastError) > 0 &&
+            static_cast<int8_t>(lastError) < 0x0C) {
+            return false;
+        }
+    }
+    return false;
+}
+
+const modbusDeviceInfo* modbusMaster::getDeviceInfo(byte slaveID) {
+    return findDeviceInfo(slaveID);
+}
+
+void modbusMaster::clearDeviceCache() {
+    memset(deviceCache, 0x00, sizeof(deviceCache));
+    nextDeviceCacheEntry = 0;
+}
+
+
+//----------------------------------------------------------------------------
+//                           REGISTER MAP FUNCTIONS
+//----------------------------------------------------------------------------
+
+uint8_t modbusMaster::mapRegisters(byte readCommand, uint16_t firstAddress,
+                                   uint16_t lastAddress, modbusRegisterRange* ranges,
+                                   uint8_t maxRanges) {
+    uint16_t maxChunks = maxReadChunks(readCommand);
+    lastError          = NO_ERROR;
+    if (maxChunks == 0 || ranges == nullptr || maxRanges == 0 ||
+        lastAddress < firstAddress) {
+        return 0;
+    }
+
+    uint8_t numRanges = 0;
+    // The blocks still to be tried.  Each split halves a block, so the stack never
+    // needs to be deeper than the number of times the largest block can be halved
+    // (11 for 2000 coils) plus one.
+    uint16_t blockStart[16];
+    uint16_t blockCount[16];
+    uint8_t  blockFlags[16];
+    // A lower half, whose upper half sits just below it on the stack
+    const uint8_t lowerHalf = 0x01;
+    // An upper half whose lower half was rejected
+    const uint8_t lowerRejected = 0x02;
+    // A block to read one address at a time
+    const uint8_t scanBlock = 0x04;
+    // The upper half of a lower half, just above its parent's upper half on the stack
+    const uint8_t upperOfLower = 0x08;
+    // An upper half whose lower half was rejected in both of its own halves
+    const uint8_t lowerSplitRejected = 0x10;
+    // Use a 32-bit position so a last address of 0xFFFF doesn't loop forever
+    uint32_t position = firstAddress;
+    while (position <= lastAddress) {
+        uint32_t remaining = static_cast<uint32_t>(lastAddress) - position + 1;
+        int      depth     = 0;
+        blockStart[0]      = position;
+        blockCount[0]      = remaining < maxChunks ? remaining : maxChunks;
+        blockFlags[0]      = 0;
+        position += blockCount[0];
+
+        while (depth >= 0) {
+            uint16_t start = blockStart[depth];
+            uint16_t count = blockCount[depth];
+            uint8_t  flags = blockFlags[depth];
+            depth--;
+            // Take the first address of a scanned block and leave the rest
+            if ((flags & scanBlock) && count > 1) {
+                depth++;
+                blockStart[depth] = start + 1;
+                blockCount[depth] = count - 1;
+                count             = 1;
+            }
+
+            if (getModbusData(_slaveID, readCommand, start, count) > 0) {
+                // Merge with the previous range if this block continues it
+                if (numRanges > 0 &&
+                    static_cast<uint32_t>(ranges[numRanges - 1].start) +
+                            ranges[numRanges - 1].count ==
+                        start) {
+                    ranges[numRanges - 1].count += count;
+                } else if (numRanges < maxRanges) {
+                    ranges[numRanges].start = start;
+                    ranges[numRanges].count = count;
+                    numRanges++;
+                } else {
+                    debugPrint(F("No room for more register ranges\n"));
+                    return numRanges;
+                }
+                continue;
+            }
+
+            switch (lastError) {
+                // The slave rejected at least one address in the block (or answered
+                // with the wrong number of bytes); split it and try each half - the
+                // lower half last so it comes off the stack first
+                case ILLEGAL_DATA_ADDRESS:
+                case ILLEGAL_DATA_VALUE:
+                case SLAVE_DEVICE_FAILURE:
+                case NO_ERROR:
+                    if (flags & lowerHalf) { blockFlags[depth] |= lowerRejected; }
+                    // Both halves of a lower half rejected; tell its upper half
+                    if ((flags & upperOfLower) && (flags & lowerRejected)) {
+                        blockFlags[depth] |= lowerSplitRejected;
+                    }
+                    if (count <= 1) { break; }
+                    // Splitting a block rejected throughout costs more than reading
+                    // it address by address; expect that of small blocks and of the
+                    // upper half of a block whose lower half was rejected in both of
+                    // its own halves
+                    if (count <= MODBUS_MAP_SCAN_SIZE || (flags & lowerSplitRejected)) {
+                        depth++;
+                        blockStart[depth] = start;
+                        blockCount[depth] = count;
+                        blockFlags[depth] = scanBlock;
+                    } else {
+                        uint16_t lowerCount   = count / 2;
+                        blockStart[depth + 1] = start + lowerCount;
+                        blockCount[depth + 1] = count - lowerCount;
+                        blockFlags[depth + 1] = (flags & lowerHalf) ? upperOfLower : 0;
+                        blockStart[depth + 2] = start;
+                        blockCount[depth + 2] = lowerCount;
+                        blockFlags[depth + 2] = lowerHalf;
+                        depth += 2;
+                    }
+                    break;
+                // Anything else means the slave can't be mapped any further
+                default:
+                    debugPrint(F("Stopped mapping at address "), start, '\n');
+                    return numRanges;
+            }
+        }
+    }
+    lastError = NO_ERROR;
+    return numRanges;
+}
+
+
 //----------------------------------------------------------------------------
 //                           LOWEST LEVEL FUNCTION
 //----------------------------------------------------------------------------
 
 // This sends a command to the sensor bus and listens for a response
 uint16_t modbusMaster::sendCommand(byte* command, int commandLength) {
+    // Add the CRC to the frame
+    insertCRC(command, commandLength);
+    return sendFrame(command, commandLength);
+}
+
+uint16_t modbusMaster::sendFrame(const byte* command, int commandLength) {
     if (_stream == nullptr) {
         debugPrint("Modbus Error: No Stream Defined!\n");
+        if (_streamHandler != nullptr) { finishStream(false); }
+        lastError = NO_RESPONSE;
+        return static_cast<uint16_t>(lastError) << 12;
+    }
+
+    // Don't send anything to a slave whose circuit is open
+    if (!circuitAllowsRequest(command[0])) {
+        debugPrint(F("Modbus Error: Circuit to slave "), command[0],
+                   F(" is open; request not sent\n"));
+        if (_streamHandler != nullptr) { finishStream(false); }
         lastError = NO_RESPONSE;
         return static_cast<uint16_t>(lastError) << 12;
     }
@@ -1024,19 +1530,35 @@ uint16_t modbusMaster::sendCommand(byte* command, int commandLength) {
     // Empty the response buffer
     memset(responseBuffer, 0x00, RESPONSE_BUFFER_SIZE);
 
-    // Add the CRC to the frame
-    insertCRC(command, commandLength);
-
     // Send out the command
     driverEnable();
     emptySerialBuffer(_stream);  // Clear any junk before sending command
+    _timing.slaveID  = command[0];
+    _timing.function = command[1];
+    _timing.rxBytes  = 0;
+    _timing.txStart  = MODBUS_MICROS();
     _stream->write(command, commandLength);
     _stream->flush();
-    receiverEnable();
+    _timing.txDone  = MODBUS_MICROS();
+    _timing.rxFirst = _timing.txDone;
+    _timing.rxLast  = _timing.txDone;
+    receiverEnable(commandLength);
     // Print the raw send (for debugging)
     debugPrint("Raw Request >>> ");
     printFrameHex(command, commandLength);
 
+    // Take our own request back off the line before looking for the response
+    if (_echoSuppression && !consumeEcho(command, commandLength)) {
+        _busCollisions++;
+        emptySerialBuffer(_stream);
+        // The collision is not the slave's fault, but a probe must not be left open
+        abandonCircuitProbe(command[0]);
+        if (_streamHandler != nullptr) { finishStream(false); }
+        lastError = BUS_COLLISION;
+        printLastError();
+        return static_cast<uint16_t>(lastError) << 12;
+    }
+
     // If the command was a broadcast (slave ID = 0), return immediately
     // Broadcast commands do not get a response
     if (command[0] == 0) {
@@ -1044,16 +1566,15 @@ uint16_t modbusMaster::sendCommand(byte* command, int commandLength) {
         return 0;
     }
 
+    bool     gotGoodResponse = true;
+    int      bytesRead       = 0;
+    uint16_t crc             = 0xFFFF;
     // Wait for a response
-    uint32_t start = millis();
-    while (_stream->available() == 0 && millis() - start < modbusTimeout) { delay(1); }
-
-
-    bool gotGoodResponse = true;
-    int  bytesRead       = 0;
-    if (_stream->available() > 0) {
+    if (waitForData(modbusTimeout, false)) {
         // Read the incoming bytes
-        bytesRead = _stream->readBytes(responseBuffer, RESPONSE_BUFFER_SIZE);
+        _timing.rxFirst = MODBUS_MICROS();
+        bytesRead       = receiveFrame(command[0], crc);
+        _timing.rxBytes = bytesRead;
         emptySerialBuffer(_stream);
 
         // Print the raw response (for debugging)
@@ -1068,13 +1589,26 @@ uint16_t modbusMaster::sendCommand(byte* command, int commandLength) {
         }
 
         // Verify that the CRC is correct
-        calculateCRC(responseBuffer, bytesRead);
-        if (crcFrame[0] != responseBuffer[bytesRead - 2] ||
-            crcFrame[1] != responseBuffer[bytesRead - 1]) {
+        // The CRC of everything before it was calculated as the bytes arrived
+        if (bytesRead < 4 || (crc & 0xFF) != responseBuffer[bytesRead - 2] ||
+            (crc >> 8) != responseBuffer[bytesRead - 1]) {
             gotGoodResponse = false;
             lastError       = BAD_CRC;
         }
 
+        // Look for a good frame behind leading noise or ahead of a stray byte
+        if (!gotGoodResponse && _frameRecovery && _streamHandler == nullptr) {
+            int recovered = recoverFrame(command, bytesRead);
+            if (recovered > 0) {
+                debugPrint(F("Recovered a "), recovered, F(" byte frame from "),
+                           bytesRead, F(" bytes\n"));
+                bytesRead       = recovered;
+                gotGoodResponse = true;
+                lastError       = NO_ERROR;
+                _recoveredFrames++;
+            }
+        }
+
         // Check for exception response
         // An exception response sets the highest bit of the function code in the
         // response.
@@ -1087,6 +1621,14 @@ uint16_t modbusMaster::sendCommand(byte* command, int commandLength) {
         lastError       = NO_RESPONSE;
     }
 
+    // Update the health of the slave
+    recordCircuitResult(command[0], bytesRead > 0);
+
+    // Accept or discard any values already handed out by a streaming read
+    if (_streamHandler != nullptr) {
+        finishStream(gotGoodResponse && bytesRead == _streamExpectedBytes + 5);
+    }
+
     if (gotGoodResponse) {
         // If everything passes, return the number of bytes
         lastError = NO_ERROR;
@@ -1115,6 +1657,9 @@ void modbusMaster::printLastError(void) {
         case GATEWAY_TARGET_DEVICE_FAILED_TO_RESPOND:
             debugPrint("Gateway Target Device Failed to Respond!\n");
             break;
+        case BUS_COLLISION:
+            debugPrint("Echo of the request did not match; bus collision!\n");
+            break;
         case WRONG_SLAVE_ID:
             debugPrint("Response is not from the correct modbus slave!\n");
             break;
@@ -1122,42 +1667,407 @@ void modbusMaster::printLastError(void) {
         case NO_RESPONSE: debugPrint("No Response!\n"); break;
         default:
             debugPrint("Unknown Error Code: ");
-            debugPrint(String(lastError, HEX));
+            printPaddedHex(static_cast<byte>(lastError));
             debugPrint("\n");
             break;
     }
 }
 
 
+//----------------------------------------------------------------------------
+//                             PREPARED REQUESTS
+//----------------------------------------------------------------------------
+
+bool modbusPreparedRequest::prepare(byte slaveID, byte readCommand,
+                                    uint16_t startAddress, uint16_t count) {
+    _expectedBytes     = 0;
+    uint16_t maxChunks = modbusMaster::maxReadChunks(readCommand);
+    if (maxChunks == 0 || count < 1 || count > maxChunks) { return false; }
+
+    _frame[0] = slaveID;
+    _frame[1] = readCommand;
+    _frame[2] = highByte(startAddress);
+    _frame[3] = lowByte(startAddress);
+    _frame[4] = highByte(count);
+    _frame[5] = lowByte(count);
+    uint16_t crc = modbusMaster::crc16(_frame, 6);
+    _frame[6]    = lowByte(crc);
+    _frame[7]    = highByte(crc);
+
+    _expectedBytes = readCommand <= 0x02 ? (count + 7) / 8 : count * 2;
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 //                           PRIVATE HELPER FUNCTIONS
 //----------------------------------------------------------------------------
 
+// These track the health of the slaves for the circuit breaker
+slaveHealth* modbusMaster::findSlaveHealth(byte slaveID, bool create) {
+    slaveHealth* unused  = nullptr;
+    slaveHealth* healthy = nullptr;
+    for (uint8_t i = 0; i < MODBUS_HEALTH_TABLE_SIZE; i++) {
+        slaveHealth* health = &healthTable[i];
+        if (health->stream == _stream && health->slaveID == slaveID) { return health; }
+        if (health->stream == nullptr) {
+            if (unused == nullptr) { unused = health; }
+        } else if (health->state == circuitClosed && health->failures == 0 &&
+                   healthy == nullptr) {
+            healthy = health;
+        }
+    }
+    if (!create) { return nullptr; }
+    // Prefer an empty entry, then one for a slave with no failures to remember.
+    // If every entry is for a failing slave, this slave just isn't tracked.
+    slaveHealth* health = unused != nullptr ? unused : healthy;
+    if (health == nullptr) { return nullptr; }
+    health->stream   = _stream;
+    health->slaveID  = slaveID;
+    health->state    = circuitClosed;
+    health->failures = 0;
+    health->backoff  = circuitBackoff;
+    health->lastTry  = MODBUS_MILLIS();
+    return health;
+}
+
+bool modbusMaster::circuitAllowsRequest(byte slaveID) {
+    // Broadcasts never get a response, so they never affect the circuit
+    if (circuitThreshold == 0 || slaveID == 0) { return true; }
+    slaveHealth* health = findSlaveHealth(slaveID);
+    if (health == nullptr || health->state == circuitClosed) { return true; }
+    // Let a single probe through once the backoff time has passed
+    if (health->state == circuitOpen &&
+        MODBUS_MILLIS() - health->lastTry >= health->backoff) {
+        health->lastTry = MODBUS_MILLIS();
+        changeCircuitState(health, circuitHalfOpen);
+        return true;
+    }
+    return false;
+}
+
+void modbusMaster::recordCircuitResult(byte slaveID, bool responded) {
+    if (circuitThreshold == 0 || slaveID == 0) { return; }
+    if (responded) {
+        slaveHealth* health = findSlaveHealth(slaveID);
+        if (health == nullptr) { return; }
+        health->failures = 0;
+        health->backoff  = circuitBackoff;
+        changeCircuitState(health, circuitClosed);
+        return;
+    }
+
+    slaveHealth* health = findSlaveHealth(slaveID, true);
+    if (health == nullptr) { return; }
+    if (health->failures < 0xFF) { health->failures++; }
+    if (health->state == circuitHalfOpen) {
+        // The probe failed; wait twice as long before the next one
+        health->backoff = health->backoff > circuitMaxBackoff / 2
+            ? circuitMaxBackoff
+            : health->backoff * 2;
+        health->lastTry = MODBUS_MILLIS();
+        changeCircuitState(health, circuitOpen);
+    } else if (health->state == circuitClosed && health->failures >= circuitThreshold) {
+        health->backoff = circuitBackoff;
+        health->lastTry = MODBUS_MILLIS();
+        changeCircuitState(health, circuitOpen);
+    }
+}
+
+void modbusMaster::abandonCircuitProbe(byte slaveID) {
+    if (circuitThreshold == 0 || slaveID == 0) { return; }
+    slaveHealth* health = findSlaveHealth(slaveID);
+    if (health == nullptr || health->state != circuitHalfOpen) { return; }
+    health->lastTry = MODBUS_MILLIS();
+    changeCircuitState(health, circuitOpen);
+}
+
+// This gets the largest number of chunks that can be written with a single command
+uint16_t modbusMaster::maxWriteChunks(byte writeCommand) {
+    // A write command has 9 bytes of modbus RTU frame around the data
+    uint16_t bufferBytes = COMMAND_BUFFER_SIZE - 9;
+    switch (writeCommand) {
+        case 0x0F:  // Coils
+            // Modbus allows up to 1968 coils at 1 bit each; keep whole bytes
+            return bufferBytes * 8 < 1968 ? bufferBytes * 8 : 1968;
+        case 0x10:  // Holding Registers
+            // Modbus allows up to 123 registers at 2 bytes each
+            return bufferBytes / 2 < 123 ? bufferBytes / 2 : 123;
+        default: return 0;
+    }
+}
+
+uint16_t modbusMaster::getDataBlock(byte readCommand, uint16_t startAddress,
+                                    uint16_t numChunks, byte* buff) {
+    // The most coils or inputs that can be read at once is always a multiple of 8, so
+    // every response lands on a byte boundary of the packed output
+    uint16_t maxChunks = maxReadChunks(readCommand);
+    bool     isBits    = readCommand == 0x01 || readCommand == 0x02;
+    uint16_t numRead   = 0;
+    lastError          = NO_ERROR;
+    if (maxChunks == 0 || buff == nullptr) {
+        lastError = ILLEGAL_FUNCTION;
+        return 0;
+    }
+    // Don't wrap around past the last address
+    if (static_cast<uint32_t>(startAddress) + numChunks > 0x10000UL) {
+        numChunks = static_cast<uint16_t>(0x10000UL - startAddress);
+    }
+    while (numRead < numChunks) {
+        uint16_t chunk   = numChunks - numRead < maxChunks ? numChunks - numRead
+                                                           : maxChunks;
+        int16_t  rxBytes = getModbusData(_slaveID, readCommand,
+                                         static_cast<int16_t>(startAddress + numRead),
+                                         static_cast<int16_t>(chunk));
+        if (rxBytes == 0) {
+            debugPrint(F("Block read stopped after "), numRead, F(" of "), numChunks,
+                       F(" values\n"));
+            break;
+        }
+        // Copy this chunk straight from the response to its place in the output
+        memcpy(buff + (isBits ? numRead / 8 : numRead * 2), responseBuffer + 3,
+               rxBytes);
+        numRead += chunk;
+    }
+    return numRead;
+}
+
+// This gets the largest number of chunks that can be read with a single command
+uint16_t modbusMaster::maxReadChunks(byte readCommand) {
+    // A response has 5 bytes of modbus RTU frame around the data
+    uint16_t bufferBytes = RESPONSE_BUFFER_SIZE - 5;
+    switch (readCommand) {
+        case 0x01:  // Coils
+        case 0x02:  // Discrete Inputs
+            // Modbus allows up to 2000 coils or inputs at 1 bit each
+            return bufferBytes * 8 < 2000 ? bufferBytes * 8 : 2000;
+        case 0x03:  // Holding Registers
+        case 0x04:  // Input Registers
+            // Modbus allows up to 125 registers at 2 bytes each
+            return bufferBytes / 2 < 125 ? bufferBytes / 2 : 125;
+        default: return 0;
+    }
+}
+
+// These request and cache the identification of a device
+modbusDeviceInfo* modbusMaster::findDeviceInfo(byte slaveID, bool create) {
+    modbusDeviceInfo* unused = nullptr;
+    for (uint8_t i = 0; i < MODBUS_DEVICE_CACHE_SIZE; i++) {
+        modbusDeviceInfo* info = &deviceCache[i];
+        if (info->stream == _stream && info->slaveID == slaveID) { return info; }
+        if (info->stream == nullptr && unused == nullptr) { unused = info; }
+    }
+    if (!create) { return nullptr; }
+    // If the cache is full, reuse the entries in turn
+    if (unused == nullptr) {
+        unused               = &deviceCache[nextDeviceCacheEntry];
+        nextDeviceCacheEntry = (nextDeviceCacheEntry + 1) % MODBUS_DEVICE_CACHE_SIZE;
+    }
+    memset(unused, 0x00, sizeof(modbusDeviceInfo));
+    unused->stream  = _stream;
+    unused->slaveID = slaveID;
+    return unused;
+}
+
+bool modbusMaster::requestServerID(byte slaveID) {
+    // The full command for Report Server ID has:
+    // - slave address (1 byte)
+    // - function = 0x11 (1 byte)
+    // - CRC hi/lo (2 bytes)
+    commandBuffer[0]  = slaveID;
+    commandBuffer[1]  = 0x11;
+    uint16_t respSize = sendCommand(commandBuffer, 4);
+    if (lastError != NO_ERROR) { return false; }
+
+    // The structure of the response should be:
+    // {slaveID, fxnCode, # bytes, server ID, run indicator, additional data, CRC}
+    if (respSize < 5 || responseBuffer[1] != 0x11 ||
+        responseBuffer[2] + 5 != respSize) {
+        debugPrint(F("Unexpected response to Report Server ID\n"));
+        return false;
+    }
+    modbusDeviceInfo* info     = findDeviceInfo(slaveID, true);
+    byte              numBytes = responseBuffer[2];
+    info->serverIDLength = numBytes < MODBUS_DEVICE_ID_LENGTH ? numBytes
+                                                              : MODBUS_DEVICE_ID_LENGTH;
+    memcpy(info->serverID, responseBuffer + 3, info->serverIDLength);
+    // Assume the common layout of a one byte server ID followed by the run indicator
+    info->runIndicator = numBytes >= 2 && responseBuffer[4] == 0xFF;
+    info->hasServerID  = true;
+    return true;
+}
+
+bool modbusMaster::requestDeviceIdentification(byte slaveID) {
+    modbusDeviceInfo* info     = nullptr;
+    byte              objectID = 0x00;
+    // A slave may need several responses to return all of the basic objects; it tells
+    // us where to pick up again.  The basic category only has three objects, so
+    // there's no need to ask more than a few times.
+    for (uint8_t part = 0; part < 3; part++) {
+        // The full command for Read Device Identification has:
+        // - slave address (1 byte)
+        // - function = 0x2B (1 byte)
+        // - MEI type = 0x0E (1 byte)
+        // - read device ID code; 0x01 for basic identification (1 byte)
+        // - object ID to start from (1 byte)
+        // - CRC hi/lo (2 bytes)
+        commandBuffer[0]  = slaveID;
+        commandBuffer[1]  = 0x2B;
+        commandBuffer[2]  = 0x0E;
+        commandBuffer[3]  = 0x01;
+        commandBuffer[4]  = objectID;
+        uint16_t respSize = sendCommand(commandBuffer, 7);
+        if (lastError != NO_ERROR) { return info != nullptr; }
+
+        // The structure of the response should be:
+        // {slaveID, fxnCode, MEI type, read device ID code, conformity level,
+        // more follows, next object ID, # objects, objects..., CRC}
+        // where each object is {object ID, object length, object value}
+        if (respSize < 10 || responseBuffer[1] != 0x2B || responseBuffer[2] != 0x0E) {
+            debugPrint(F("Unexpected response to Read Device Identification\n"));
+            return info != nullptr;
+        }
+        if (info == nullptr) { info = findDeviceInfo(slaveID, true); }
+
+        int dataEnd = respSize - 2;
+        int pos     = 8;
+        for (uint8_t i = 0; i < responseBuffer[7] && pos + 2 <= dataEnd; i++) {
+            byte objectLength = responseBuffer[pos + 1];
+            if (pos + 2 + objectLength > dataEnd) { break; }
+            char* dest = nullptr;
+            switch (responseBuffer[pos]) {
+                case 0x00: dest = info->vendorName; break;
+                case 0x01: dest = info->productCode; break;
+                case 0x02: dest = info->revision; break;
+                default: break;
+            }
+            if (dest != nullptr) {
+                byte numChars = objectLength < MODBUS_DEVICE_ID_LENGTH
+                    ? objectLength
+                    : MODBUS_DEVICE_ID_LENGTH;
+                memcpy(dest, responseBuffer + pos + 2, numChars);
+                dest[numChars] = '\0';
+            }
+            pos += 2 + objectLength;
+        }
+        info->hasIdentification = true;
+
+        // Stop unless the slave says more objects follow
+        if (responseBuffer[5] != 0xFF) { break; }
+        objectID = responseBuffer[6];
+    }
+    return info != nullptr;
+}
+
+void modbusMaster::changeCircuitState(slaveHealth* health, circuitState newState) {
+    if (health->state == newState) { return; }
+    health->state = newState;
+    switch (newState) {
+        case circuitClosed:
+            debugPrint(F("Circuit to slave "), health->slaveID, F(" closed\n"));
+            break;
+        case circuitOpen:
+            debugPrint(F("Circuit to slave "), health->slaveID, F(" opened after "),
+                       health->failures, F(" failures; next probe in "),
+                       health->backoff, F(" ms\n"));
+            break;
+        case circuitHalfOpen:
+            debugPrint(F("Probing slave "), health->slaveID, '\n');
+            break;
+    }
+    if (_circuitCallback != nullptr) { _circuitCallback(health->slaveID, newState); }
+}
+
 // This flips the device/receive enable to DRIVER so the arduino can send text
 void modbusMaster::driverEnable(void) {
     if (_enablePin >= 0) {
         pinMode(_enablePin, OUTPUT);
         digitalWrite(_enablePin, HIGH);
         debugPrint("RS485 Driver/Master Tx Enabled\n");
-        delay(8);
+        // Only the transceiver needs to settle; the line has been quiet since the
+        // last response
+        if (_driverSettle > 0) { MODBUS_DELAY_MICROS(_driverSettle); }
     }
 }
 
 // This flips the device/receive enable to RECEIVER so the sensor can send text
-void modbusMaster::receiverEnable(void) {
+void modbusMaster::receiverEnable(int frameLength) {
     if (_enablePin >= 0) {
+        // Some cores return from flush() when the last byte has been handed to the
+        // UART, not when its stop bit has gone out; don't cut it off
+        if (_baudRate > 0) {
+            uint32_t frameTime = frameLength * charTimeMicros(_baudRate);
+            while (MODBUS_MICROS() - _timing.txStart < frameTime) { MODBUS_IDLE(); }
+        }
+        if (_driverHold > 0) { MODBUS_DELAY_MICROS(_driverHold); }
         pinMode(_enablePin, OUTPUT);
         digitalWrite(_enablePin, LOW);
         debugPrint("RS485 Receiver/Slave Tx Enabled\n");
-        // delay(8);
     }
 }
 
+// This slides along the response buffer looking for a frame that starts with the
+// slave ID and function of the request, has the length that function implies, and
+// ends with a good CRC
+int modbusMaster::recoverFrame(const byte* command, int bytesRead) {
+    for (int start = 0; start + 4 <= bytesRead; start++) {
+        const byte* frame = responseBuffer + start;
+        if (frame[0] != command[0] || (frame[1] & 0x7F) != command[1]) { continue; }
+
+        int length;
+        if (frame[1] & 0x80) {
+            length = 5;  // An exception
+        } else {
+            switch (frame[1]) {
+                case 0x01:
+                case 0x02:
+                case 0x03:
+                case 0x04:
+                case 0x11:
+                case 0x17: length = 5 + frame[2]; break;  // A byte count and data
+                case 0x05:
+                case 0x06:
+                case 0x08:
+                case 0x0F:
+                case 0x10: length = 8; break;  // An echo of the request header
+                default: length = bytesRead - start; break;
+            }
+        }
+        if (start + length > bytesRead || (start == 0 && length == bytesRead)) {
+            continue;
+        }
+
+        uint16_t crc = crc16(frame, length - 2);
+        if ((crc & 0xFF) != frame[length - 2] || (crc >> 8) != frame[length - 1]) {
+            continue;
+        }
+        memmove(responseBuffer, frame, length);
+        return length;
+    }
+    return 0;
+}
+
+// This reads the echo of a request and checks it byte by byte
+bool modbusMaster::consumeEcho(const byte* frame, int frameLength) {
+    bool matched = true;
+    for (int i = 0; i < frameLength; i++) {
+        // The echo of the last bytes can still be arriving after flush() returns
+        if (!waitForData(modbusFrameTimeout, true)) {
+            debugPrint(F("Echo ended after "), i, F(" of "), frameLength,
+                       F(" bytes\n"));
+            return false;
+        }
+        if (_stream->read() != frame[i]) { matched = false; }
+    }
+    if (!matched) { debugPrint(F("Echo did not match the request\n")); }
+    return matched;
+}
+
 // This empties the serial buffer
 void modbusMaster::emptySerialBuffer(Stream* stream) {
     while (stream->available() > 0) {
         stream->read();
-        delay(modbusFrameTimeout);
+        MODBUS_DELAY(modbusFrameTimeout);
     }
 }
 
@@ -1168,7 +2078,7 @@ void modbusMaster::printPaddedHex(byte value) {
     buf[4] = '\0';
     debugPrint(buf);
 }
-void modbusMaster::printFrameHex(byte* modbusFrame, int frameLength) {
+void modbusMaster::printFrameHex(const byte* modbusFrame, int frameLength) {
     debugPrint("{");
     for (int i = 0; i < frameLength; i++) {
         printPaddedHex(modbusFrame[i]);
@@ -1196,23 +2106,8 @@ void modbusMaster::printArraySlice(byte*, int, int) {}
 // and: https://stackoverflow.com/questions/19347685/calculating-modbus-rtu-crc-16
 //
 void modbusMaster::calculateCRC(byte* modbusFrame, int frameLength) {
-    // Reset the CRC frame
-    modbusMaster::crcFrame[0] = {0x00};
-    modbusMaster::crcFrame[1] = {0x00};
-
-    uint16_t crc = 0xFFFF;
-    for (int pos = 0; pos < frameLength - 2; pos++) {
-        crc ^= (unsigned int)modbusFrame[pos];  // XOR byte into least sig. byte of crc
-
-        for (int i = 8; i != 0; i--) {  // Loop over each bit
-            if ((crc & 0x0001) != 0) {  // If the least significant bit (LSB) is set
-                crc >>= 1;              // Shift right and XOR 0xA001
-                crc ^= 0xA001;
-            } else {        // Else least significant bit (LSB) is not set
-                crc >>= 1;  // Just shift right
-            }
-        }
-    }
+    // The CRC covers everything but the two CRC bytes at the end of the frame
+    uint16_t crc = frameLength > 2 ? crc16(modbusFrame, frameLength - 2) : 0xFFFF;
 
     // Break into low and high bytes
     byte crcLow  = crc & 0xFF;
@@ -1231,6 +2126,86 @@ void modbusMaster::insertCRC(byte* modbusFrame, int frameLength) {
     modbusFrame[frameLength - 1] = crcFrame[1];
 }
 
+int modbusMaster::receiveFrame(byte slaveID, uint16_t& crc) {
+    int      bytesRead = 0;
+    bool     streamOK  = false;
+    uint32_t lastByte  = MODBUS_MILLIS();
+    crc                = 0xFFFF;
+    // Keep reading until the line goes quiet for a frame timeout
+    while (bytesRead < RESPONSE_BUFFER_SIZE) {
+        if (_stream->available() <= 0) {
+            uint32_t quiet = MODBUS_MILLIS() - lastByte;
+            if (quiet >= static_cast<uint32_t>(modbusFrameTimeout) ||
+                !waitForData(modbusFrameTimeout - quiet, true)) {
+                break;
+            }
+        }
+        responseBuffer[bytesRead++] = _stream->read();
+        lastByte                    = MODBUS_MILLIS();
+        _timing.rxLast              = MODBUS_MICROS();
+        // Each byte is known not to be part of the CRC once two more follow it
+        if (bytesRead > 2) { crc = crcUpdate(crc, responseBuffer[bytesRead - 3]); }
+
+        if (_streamHandler == nullptr) { continue; }
+        // Only hand out values once the header shows this is the data we asked for
+        if (bytesRead == 3) {
+            streamOK = responseBuffer[0] == slaveID &&
+                (responseBuffer[1] & 0b10000000) == 0 &&
+                responseBuffer[2] == _streamExpectedBytes;
+        }
+        int dataBytes = bytesRead - 3;
+        if (streamOK && dataBytes > 0 && dataBytes <= _streamExpectedBytes &&
+            dataBytes % _streamElementBytes == 0) {
+            const byte* value = responseBuffer + bytesRead - _streamElementBytes;
+            leFrame     fram  = {{0, 0, 0, 0}};
+            for (uint8_t i = 0; i < _streamElementBytes; i++) {
+                fram.Byte[i] = _streamEndian == bigEndian
+                    ? value[_streamElementBytes - 1 - i]
+                    : value[i];
+            }
+            _streamHandler->element(_streamFirstElement + _streamPending, fram);
+            _streamPending++;
+        }
+    }
+    return bytesRead;
+}
+
+bool modbusMaster::waitForData(uint32_t timeout, bool spin) {
+    if (_stream->available() > 0) { return true; }
+    if (_dataWaitFunction != nullptr) { return _dataWaitFunction(_stream, timeout); }
+    if (_waitStrategy == waitDelay && !spin) {
+        uint32_t start = MODBUS_MILLIS();
+        while (_stream->available() <= 0) {
+            if (MODBUS_MILLIS() - start >= timeout) { return false; }
+            MODBUS_DELAY(1);
+        }
+        return true;
+    }
+
+    // Time the wait in µs; the longest wait that fits is a bit over an hour
+    uint32_t limit = timeout < 4000000UL ? timeout * 1000UL : 4000000000UL;
+    uint32_t start = MODBUS_MICROS();
+    while (_stream->available() <= 0) {
+        uint32_t elapsed = MODBUS_MICROS() - start;
+        if (elapsed >= limit) { return false; }
+        if (_waitCallback != nullptr &&
+            (_waitStrategy == waitYield || _waitStrategy == waitSleep)) {
+            _waitCallback(limit - elapsed);
+        }
+        MODBUS_IDLE();
+    }
+    return true;
+}
+
+void modbusMaster::finishStream(bool good) {
+    if (good && _streamPending == _streamExpectedBytes / _streamElementBytes) {
+        _streamHandler->commit(_streamPending);
+    } else {
+        _streamHandler->rollback(_streamPending);
+    }
+    _streamPending = 0;
+}
+
 // This slices one array out of another
 // Used for slicing one or more registers out of a returned modbus RTU frame
 void modbusMaster::sliceArray(byte inputArray[], byte outputArray[], int start_index,
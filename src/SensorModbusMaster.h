@@ -21,6 +21,18 @@
 // frame to the serial port
 // #define MODBUSMASTER_DEBUG_SLICE
 
+// Uncomment the next line (or add it to your build flags) to leave out every function
+// that uses Arduino String objects; use the text functions with your own buffers
+// instead
+// #define MODBUSMASTER_NO_STRING
+
+// Uncomment the next line (or add it to your build flags) to run all of the library's
+// timing on a simulated clock; see SensorModbusClock.h
+// #define MODBUSMASTER_VIRTUAL_CLOCK
+
+#include "SensorModbusClock.h"
+#include "SensorModbusFrames.h"
+
 /**
  * @brief The size of the response buffer for the modbus devices.
  *
@@ -52,6 +64,77 @@
  * between characters in a frame and any space over 3.5 characters defines a new frame.
  */
 #define MODBUS_FRAME_TIMEOUT 4
+/**
+ * @brief The number of slaves whose health can be tracked by the circuit breaker.
+ *
+ * The table is shared by all modbusMaster objects. Only slaves that have failed to
+ * respond take up a place in the table; healthy slaves are evicted first when it is
+ * full. Each entry costs about 12 bytes of RAM.
+ */
+#define MODBUS_HEALTH_TABLE_SIZE 4
+/**
+ * @brief The default time to wait before probing a slave whose circuit is open (in
+ * ms)
+ *
+ * The wait is doubled after every failed probe, up to #MODBUS_CIRCUIT_MAX_BACKOFF.
+ */
+#define MODBUS_CIRCUIT_BACKOFF 1000
+/**
+ * @brief The default maximum time to wait between probes of a slave whose circuit is
+ * open (in ms)
+ */
+#define MODBUS_CIRCUIT_MAX_BACKOFF 60000
+/**
+ * @brief The default time to wait for a response to a discovery probe (in ms)
+ *
+ * Discovery probes are only tried once. This must be long enough for the probe and
+ * the start of the response to cross the wire plus the slave's turn-around time. At
+ * 9600 baud the probe takes about 4ms to send.
+ */
+#define MODBUS_DISCOVERY_TIMEOUT 30
+/**
+ * @brief The number of devices whose identification is cached by the discovery
+ * functions.
+ *
+ * The cache is shared by all modbusMaster objects. Each entry costs roughly
+ * 4 x #MODBUS_DEVICE_ID_LENGTH bytes of RAM.
+ */
+#define MODBUS_DEVICE_CACHE_SIZE 4
+/**
+ * @brief The maximum number of characters or bytes kept for each identification
+ * object of a device (ie, the vendor name or the server ID).
+ *
+ * Longer values are truncated.
+ */
+#define MODBUS_DEVICE_ID_LENGTH 16
+/**
+ * @brief The time allowed for a slave to start answering a probe while detecting its
+ * serial settings (in ms)
+ *
+ * This is added to the time it takes to send the probe and the first byte of the
+ * response at each candidate baud rate.
+ */
+#define MODBUS_DETECT_TURNAROUND 20
+/**
+ * @brief The largest rejected block that modbusMaster::mapRegisters() reads one
+ * address at a time instead of splitting in half
+ */
+#define MODBUS_MAP_SCAN_SIZE 4
+/**
+ * @brief The time an RS485 driver takes to turn on after its enable pin is raised (in
+ * µs)
+ *
+ * Common transceivers (ie, MAX485, SP3485) need a few µs; raise this for slow level
+ * shifters or opto-isolators.  See modbusMaster::setDriverTiming().
+ */
+#define MODBUS_DRIVER_SETTLE 20
+/**
+ * @brief The time to keep an RS485 driver on after the last stop bit has been sent
+ * (in µs)
+ *
+ * See modbusMaster::setDriverTiming().
+ */
+#define MODBUS_DRIVER_HOLD 0
 
 /**
  * @brief The "endianness" of returned values
@@ -61,6 +144,17 @@ typedef enum endianness {
     bigEndian          ///< big endian
 } endianness;
 
+/**
+ * @brief The types of numbers that can be stored in registers
+ */
+typedef enum modbusDataType {
+    uint16Value = 0,  ///< one register holding a uint16_t
+    int16Value,       ///< one register holding an int16_t
+    uint32Value,      ///< two registers holding a uint32_t
+    int32Value,       ///< two registers holding an int32_t
+    float32Value      ///< two registers holding a 32-bit float
+} modbusDataType;
+
 /**
  * @brief The types of "pointers" to other modbus addresses.
  *
@@ -102,12 +196,136 @@ typedef enum modbusErrorCode {
     GATEWAY_TARGET_DEVICE_FAILED_TO_RESPOND =
         0x0B,  ///< The gateway target device failed to respond
     // additional codes in this library
+    BUS_COLLISION  = 0xC,  ///< The echo of the request did not match what was sent
     WRONG_SLAVE_ID = 0xD,  ///< The response is not from the correct modbus slave
     BAD_CRC        = 0xE,  ///< The CRC check on the response failed
     NO_RESPONSE    = 0xF,  ///< No response was received at all
 
 } modbusErrorCode;
 
+/**
+ * @brief The state of the circuit breaker for a single modbus slave.
+ */
+typedef enum circuitState {
+    circuitClosed = 0,  ///< The slave is healthy; requests are sent normally
+    circuitOpen,        ///< The slave has stopped responding; requests fail without
+                        ///< being sent until the next probe is due
+    circuitHalfOpen     ///< A single probe request is being sent to the slave
+} circuitState;
+
+/**
+ * @brief A callback for changes in the circuit state of a slave.
+ *
+ * @param slaveID The byte identifier of the modbus slave whose state changed.
+ * @param newState The new circuit state of the slave.
+ */
+typedef void (*circuitStateCallback)(byte slaveID, circuitState newState);
+
+/**
+ * @brief The health record of a single modbus slave, as kept by the circuit breaker.
+ */
+typedef struct slaveHealth {
+    Stream*      stream;    ///< The stream the slave is on; nullptr for an unused entry
+    byte         slaveID;   ///< The byte identifier of the modbus slave
+    circuitState state;     ///< The current circuit state
+    uint8_t      failures;  ///< The number of consecutive requests with no response
+    uint32_t     backoff;   ///< The current time to wait between probes (in ms)
+    uint32_t     lastTry;   ///< The time the circuit opened or was last probed (in ms)
+} slaveHealth;
+
+/**
+ * @brief The identification of a modbus slave, as found by the discovery functions.
+ *
+ * The server ID is filled from the response to a Report Server ID (0x11) request. The
+ * vendor name, product code, and revision are filled from the basic objects of a Read
+ * Device Identification (0x2B / 0x0E) request. Devices do not have to support either
+ * function.
+ */
+typedef struct modbusDeviceInfo {
+    Stream* stream;   ///< The stream the device is on; nullptr for an unused entry
+    byte    slaveID;  ///< The byte identifier of the modbus slave
+    bool    hasServerID;     ///< True if the device answered Report Server ID
+    byte    serverIDLength;  ///< The number of bytes kept in serverID
+    /**
+     * @brief The data returned by Report Server ID.
+     *
+     * The content is device specific, but the first byte is usually the server ID and
+     * the second the run indicator status.
+     */
+    byte serverID[MODBUS_DEVICE_ID_LENGTH];
+    bool runIndicator;       ///< True if the run indicator status was ON (0xFF)
+    bool hasIdentification;  ///< True if the device answered Read Device Identification
+    char vendorName[MODBUS_DEVICE_ID_LENGTH + 1];   ///< The VendorName object
+    char productCode[MODBUS_DEVICE_ID_LENGTH + 1];  ///< The ProductCode object
+    char revision[MODBUS_DEVICE_ID_LENGTH + 1];     ///< The MajorMinorRevision object
+} modbusDeviceInfo;
+
+/**
+ * @brief A range of consecutive readable addresses, as found by
+ * modbusMaster::mapRegisters().
+ */
+typedef struct modbusRegisterRange {
+    uint16_t start;  ///< The first readable address in the range
+    uint16_t count;  ///< The number of consecutive readable addresses
+} modbusRegisterRange;
+
+/**
+ * @brief A serial port setting to try when detecting the settings a slave uses.
+ */
+typedef struct modbusSerialConfig {
+    uint32_t baudRate;  ///< The baud rate
+    /**
+     * @brief The data, parity, and stop bit setting, as passed to the second argument
+     * of the port's begin function (ie, SERIAL_8N1).
+     */
+    uint32_t config;
+} modbusSerialConfig;
+
+/**
+ * @brief A callback for each device found while discovering the slaves on a bus.
+ *
+ * @param info The cached identification of the device that was found.
+ */
+typedef void (*discoveryCallback)(const modbusDeviceInfo& info);
+
+/**
+ * @brief A function that waits until a stream has data to read.
+ *
+ * Use this to let a serial backend sleep until data arrives (ie, with poll() on
+ * Linux) instead of checking the stream every millisecond.
+ *
+ * @param stream The stream to wait on.
+ * @param timeout The longest time to wait (in ms).
+ * @return True if the stream has data to read.
+ */
+typedef bool (*dataWaitFunction)(Stream* stream, uint32_t timeout);
+
+/**
+ * @brief How the library waits for a response to start arriving.
+ */
+typedef enum modbusWaitStrategy {
+    waitDelay = 0,  ///< Check the stream once a millisecond with delay(); the default
+    waitSpin,       ///< Check the stream continuously, timing the wait with micros()
+    waitYield,      ///< Check the stream continuously, calling the wait callback
+                    ///< between checks to service other work
+    waitSleep       ///< Call the wait callback to sleep until an interrupt (ie, from
+                    ///< the UART receiving a byte) between checks
+} modbusWaitStrategy;
+
+/**
+ * @brief A function called between checks of the stream while waiting for data.
+ *
+ * With #waitYield, this should do a short piece of other work (ie, feed a watchdog or
+ * service other I/O) and return.  With #waitSleep, this should put the processor in a
+ * sleep mode that wakes on the UART receive interrupt, ie, `sleep_mode()` in
+ * `SLEEP_MODE_IDLE` on an AVR or `__WFI()` on an ARM.  Any other interrupt, such as the
+ * millis() timer, may also wake it; the library checks the stream and the timeout and
+ * calls it again.
+ *
+ * @param remaining The longest time left to wait (in µs).
+ */
+typedef void (*waitCallback)(uint32_t remaining);
+
 
 /**
  * @brief A frame for holding parts of a response.
@@ -160,6 +378,387 @@ typedef union leFrame {
 // Per the TAI64 standard, this value is always big-endian
 // https://www.tai64.com/
 
+/**
+ * @brief The times of the steps of one modbus transaction.
+ *
+ * All times are from MODBUS_MICROS() (normally micros()), so they wrap about every 70
+ * minutes; always subtract them instead of comparing them.  The time the slave took to
+ * answer is `rxFirst - txDone` and the time the response took to arrive is
+ * `rxLast - rxFirst`.  The first and last bytes are timed when the library sees them,
+ * so they are late by at most the time it takes to check the stream.
+ */
+typedef struct modbusTiming {
+    uint32_t txStart;  ///< When the first byte of the request was written
+    uint32_t txDone;   ///< When the request finished sending (after flush)
+    uint32_t rxFirst;  ///< When the first byte of the response was seen
+    uint32_t rxLast;   ///< When the last byte of the response was read
+    uint16_t rxBytes;  ///< The number of response bytes; 0 if there was no response
+    byte     slaveID;  ///< The slave the request was sent to
+    byte     function; ///< The function code of the request
+} modbusTiming;
+
+/**
+ * @brief A read-only view of the data in a modbus response frame.
+ *
+ * A view does not copy anything; it points directly at the data bytes of the response
+ * (after the slave ID, function code, and byte count) in the modbusMaster response
+ * buffer.
+ *
+ * @warning The response buffer is shared by all modbusMaster objects. A view is only
+ * valid until the next command is sent by *any* modbusMaster object. Copy out what you
+ * need to keep with copyTo() before sending another command.
+ *
+ * Register accessors take the index of the (first) register within the view, not the
+ * byte index. Endianness follows the rest of the library: big endian means the most
+ * significant byte is first for the whole value.
+ */
+class modbusFrameView {
+ public:
+    /**
+     * @brief Construct an empty (invalid) view
+     */
+    modbusFrameView() : _data(nullptr), _size(0), _timing() {}
+    /**
+     * @brief Construct a view of existing data
+     *
+     * @param data A pointer to the first data byte
+     * @param size The number of data bytes
+     * @param timing The timing of the transaction the data came from. Optional with
+     * a default of all zeros.
+     */
+    modbusFrameView(const byte* data, uint16_t size,
+                    const modbusTiming& timing = modbusTiming())
+        : _data(data),
+          _size(size),
+          _timing(timing) {}
+
+    /**
+     * @brief Check if the view holds data; views returned from failed reads are
+     * empty.
+     *
+     * @return True if the view holds data.
+     */
+    bool valid() const {
+        return _data != nullptr;
+    }
+    /**
+     * @brief Get a pointer to the first data byte
+     *
+     * @return A pointer to the first data byte; nullptr for an empty view.
+     */
+    const byte* data() const {
+        return _data;
+    }
+    /**
+     * @brief Get the number of data bytes
+     *
+     * @return The number of data bytes.
+     */
+    uint16_t size() const {
+        return _size;
+    }
+    /**
+     * @brief Get the timing of the transaction the data came from
+     *
+     * Unlike the data, the timing is copied into the view and stays valid.
+     *
+     * @return The transaction timing.
+     */
+    const modbusTiming& timing() const {
+        return _timing;
+    }
+    /**
+     * @brief Get the number of whole registers in the view
+     *
+     * @return The number of 16-bit registers.
+     */
+    uint16_t registerCount() const {
+        return _size / 2;
+    }
+
+    /**
+     * @brief Get a register as a uint16_t
+     *
+     * @param index The index of the register within the view.
+     * @param endian The endianness of the value. Optional with a default of big endian.
+     * @return The value; 0 if the register is outside of the view.
+     */
+    uint16_t uint16At(uint16_t index, endianness endian = bigEndian) const {
+        return valueAt(index, 2, endian).uInt16[0];
+    }
+    /**
+     * @brief Get a register as an int16_t
+     * @copydetails modbusFrameView::uint16At(uint16_t, endianness) const
+     */
+    int16_t int16At(uint16_t index, endianness endian = bigEndian) const {
+        return valueAt(index, 2, endian).Int16[0];
+    }
+    /**
+     * @brief Get two registers as a uint32_t
+     *
+     * @param index The index of the first of the two registers within the view.
+     * @param endian The endianness of the value. Optional with a default of big endian.
+     * @return The value; 0 if the registers are outside of the view.
+     */
+    uint32_t uint32At(uint16_t index, endianness endian = bigEndian) const {
+        return valueAt(index, 4, endian).uInt32;
+    }
+    /**
+     * @brief Get two registers as an int32_t
+     * @copydetails modbusFrameView::uint32At(uint16_t, endianness) const
+     */
+    int32_t int32At(uint16_t index, endianness endian = bigEndian) const {
+        return valueAt(index, 4, endian).Int32;
+    }
+    /**
+     * @brief Get two registers as a 32-bit float
+     * @copydetails modbusFrameView::uint32At(uint16_t, endianness) const
+     */
+    float float32At(uint16_t index, endianness endian = bigEndian) const {
+        return valueAt(index, 4, endian).Float32;
+    }
+    /**
+     * @brief Get the raw bits of a value of any type
+     *
+     * 16-bit values are in the low half.
+     *
+     * @param index The index of the first register of the value within the view.
+     * @param type The type of the value.
+     * @param endian The endianness of the value. Optional with a default of big endian.
+     * @return The raw bits; 0 if the value is outside of the view.
+     */
+    uint32_t rawAt(uint16_t index, modbusDataType type,
+                   endianness endian = bigEndian) const {
+        return valueAt(index, registersFor(type) * 2, endian).uInt32;
+    }
+    /**
+     * @brief Get a value of any type as a float
+     *
+     * 32-bit integers larger than 2^24 lose precision.
+     *
+     * @copydetails modbusFrameView::rawAt(uint16_t, modbusDataType, endianness) const
+     */
+    float numberAt(uint16_t index, modbusDataType type,
+                   endianness endian = bigEndian) const {
+        leFrame fram = valueAt(index, registersFor(type) * 2, endian);
+        switch (type) {
+            case int16Value: return fram.Int16[0];
+            case uint32Value: return static_cast<float>(fram.uInt32);
+            case int32Value: return static_cast<float>(fram.Int32);
+            case float32Value: return fram.Float32;
+            default: return fram.uInt16[0];
+        }
+    }
+    /**
+     * @brief Get the number of registers a type of value takes
+     *
+     * @param type The type of the value.
+     * @return The number of registers (1 or 2).
+     */
+    static constexpr uint8_t registersFor(modbusDataType type) {
+        return type == uint16Value || type == int16Value ? 1 : 2;
+    }
+    /**
+     * @brief Get the state of a single coil or discrete input
+     *
+     * @param index The index of the coil or input within the view; the first coil
+     * read is 0.
+     * @return The state of the coil or input (true for ON); false if the index is
+     * outside of the view.
+     */
+    bool bitAt(uint16_t index) const {
+        if (_data == nullptr || index / 8 >= _size) { return false; }
+        return (_data[index / 8] >> (index % 8)) & 0x01;
+    }
+
+    /**
+     * @brief Copy the data out of the view
+     *
+     * @param dest The buffer to copy to.
+     * @param maxBytes The size of the buffer.
+     * @return The number of bytes copied.
+     */
+    uint16_t copyTo(byte* dest, uint16_t maxBytes) const {
+        if (_data == nullptr || dest == nullptr) { return 0; }
+        uint16_t numBytes = _size < maxBytes ? _size : maxBytes;
+        memcpy(dest, _data, numBytes);
+        return numBytes;
+    }
+
+ private:
+    /**
+     * @brief Convert 2 or 4 bytes of the view into a little-endian frame
+     *
+     * @param index The index of the first register of the value.
+     * @param numBytes The size of the value in bytes.
+     * @param endian The endianness of the value in the view.
+     * @return The little-endian frame; all zeros if out of range.
+     */
+    leFrame valueAt(uint16_t index, uint8_t numBytes, endianness endian) const {
+        leFrame  fram  = {{0, 0, 0, 0}};
+        uint32_t first = static_cast<uint32_t>(index) * 2;
+        if (_data == nullptr || first + numBytes > _size) { return fram; }
+        for (uint8_t i = 0; i < numBytes; i++) {
+            fram.Byte[i] = endian == bigEndian ? _data[first + numBytes - 1 - i]
+                                               : _data[first + i];
+        }
+        return fram;
+    }
+
+    const byte*  _data;    ///< The first data byte of the view
+    uint16_t     _size;    ///< The number of data bytes in the view
+    modbusTiming _timing;  ///< The timing of the transaction
+};
+
+/**
+ * @brief An interface for receiving register values one at a time while a response is
+ * still arriving.
+ *
+ * Pass an object implementing this interface to modbusMaster::streamRegisters().  As
+ * each value of the response is received, element() is called with the decoded value.
+ * Those values are tentative until the whole frame has arrived and its CRC has been
+ * checked: every attempt at a request ends with exactly one call to either commit()
+ * (the values are good) or rollback() (discard everything since the last commit).
+ *
+ * @note The functions are called from within the receive loop; keep them short so no
+ * incoming bytes are lost.
+ */
+class modbusElementHandler {
+ public:
+    /**
+     * @brief Destroy the modbus Element Handler object
+     */
+    virtual ~modbusElementHandler() {}
+    /**
+     * @brief Receive one tentative value
+     *
+     * @param index The index of the value within the whole read, counting from 0.
+     * @param value The value, already converted from the endianness of the slave.  Use
+     * the member of the frame matching the element size of the read.
+     */
+    virtual void element(uint16_t index, const leFrame& value) = 0;
+    /**
+     * @brief Accept the values received since the last commit or rollback
+     *
+     * @param numElements The number of values accepted.
+     */
+    virtual void commit(uint16_t numElements) {
+        (void)numElements;
+    }
+    /**
+     * @brief Discard the values received since the last commit or rollback
+     *
+     * @param numElements The number of values discarded; this may be 0.
+     */
+    virtual void rollback(uint16_t numElements) {
+        (void)numElements;
+    }
+};
+
+/**
+ * @brief A read request built and CRC stamped once, to be sent again and again.
+ *
+ * A prepared request holds the complete 8 byte frame for a read of coils, discrete
+ * inputs, or registers.  Sending it with modbusMaster::getModbusData(const
+ * modbusPreparedRequest&) skips building the frame and calculating the CRC, so a
+ * periodic poll costs only the time on the bus.
+ */
+class modbusPreparedRequest {
+ public:
+    /**
+     * @brief Construct an empty prepared request; prepare() it before sending it
+     */
+    modbusPreparedRequest() : _frame(), _expectedBytes(0) {}
+    /**
+     * @brief Construct and prepare a request
+     *
+     * @copydetails modbusPreparedRequest::prepare(byte, byte, uint16_t, uint16_t)
+     */
+    modbusPreparedRequest(byte slaveID, byte readCommand, uint16_t startAddress,
+                          uint16_t count)
+        : _frame(),
+          _expectedBytes(0) {
+        prepare(slaveID, readCommand, startAddress, count);
+    }
+    /**
+     * @brief Construct a request from a frame built at compile time
+     *
+     * With a constexpr frame, the whole request is built by the compiler:
+     * @code{.cpp}
+     * constexpr modbusPreparedRequest poll(modbusReadFrame(0x01, 0x03, 0x0100, 10));
+     * static_assert(poll.valid(), "bad poll request");
+     * @endcode
+     *
+     * @param frame A frame from modbusReadFrame(); if it is not a valid read, or the
+     * response would not fit in the response buffer, the request is not valid.
+     */
+    constexpr explicit modbusPreparedRequest(const modbusFrame<8>& frame)
+        : _frame{frame.data[0], frame.data[1], frame.data[2], frame.data[3],
+                 frame.data[4], frame.data[5], frame.data[6], frame.data[7]},
+          _expectedBytes(expectedFor(frame)) {}
+
+    /**
+     * @brief Build the request frame and its CRC
+     *
+     * @param slaveID The modbus slave ID of the device to read from.
+     * @param readCommand The command to use: 0x01 (coils), 0x02 (discrete inputs),
+     * 0x03 (holding registers), or 0x04 (input registers).
+     * @param startAddress The first coil, input, or register to read.
+     * @param count The number of coils, inputs, or registers to read.
+     * @return True if the request is valid: a read command with a count that fits in
+     * one response.
+     */
+    bool prepare(byte slaveID, byte readCommand, uint16_t startAddress, uint16_t count);
+
+    /**
+     * @brief Check if the request has been prepared and can be sent
+     *
+     * @return True if the request can be sent.
+     */
+    constexpr bool valid() const {
+        return _expectedBytes > 0;
+    }
+    /**
+     * @brief Get the complete frame, including the CRC
+     *
+     * @return A pointer to the 8 byte frame.
+     */
+    constexpr const byte* frame() const {
+        return _frame;
+    }
+    /**
+     * @brief Get the number of data bytes a good response holds
+     *
+     * @return The number of data bytes expected.
+     */
+    constexpr uint8_t expectedBytes() const {
+        return _expectedBytes;
+    }
+
+ private:
+    /// @cond
+    // The data bytes of the response to a frame, or 0 if it is not a read that fits
+    static constexpr uint16_t expectedFor(const modbusFrame<8>& frame,
+                                          uint16_t          count) {
+        return (frame.data[1] == 0x01 || frame.data[1] == 0x02) ? (count + 7) / 8
+            : (frame.data[1] == 0x03 || frame.data[1] == 0x04)  ? count * 2
+                                                                : 0;
+    }
+    // The number of values a read frame asks for
+    static constexpr uint16_t countOf(const modbusFrame<8>& frame) {
+        return static_cast<uint16_t>((frame.data[4] << 8) | frame.data[5]);
+    }
+    static constexpr uint8_t expectedFor(const modbusFrame<8>& frame) {
+        return frame.valid() &&
+                expectedFor(frame, countOf(frame)) <= RESPONSE_BUFFER_SIZE - 5
+            ? static_cast<uint8_t>(expectedFor(frame, countOf(frame)))
+            : 0;
+    }
+    /// @endcond
+    byte    _frame[8];       ///< The request frame
+    uint8_t _expectedBytes;  ///< The number of data bytes expected in the response
+};
+
 /**
  * @brief The class for communicating with modbus devices.
  */
@@ -288,7 +887,7 @@ class modbusMaster {
      * @brief Set the enable pin
      *
      * @param enablePin The pin connected the the enable (direction control) of an RS485
-     * to TTL adapter.
+     * to TTL adapter.  Use -1 for adapters with automatic direction control.
      */
     void setEnablePin(int8_t enablePin);
     /**
@@ -299,57 +898,147 @@ class modbusMaster {
      */
     int8_t getEnablePin();
     /**
-     * @brief Set the timeout to wait for a response from a sensor after a modbus
-     * command.
+     * @brief Set the baud rate the stream was begun at
      *
-     * By default, this is #MODBUS_TIMEOUT (500 milliseconds).
+     * The library cannot read the baud rate from a stream.  When it is set, the driver
+     * is kept enabled until the whole request has had time to leave the UART, even on
+     * cores whose flush() returns before the last byte has been sent.  When it is 0
+     * (the default), the library relies on flush() alone.  detectSerialConfig() sets
+     * this to the baud rate it finds.
      *
-     * @param timeout The timeout value in milliseconds.
+     * @param baudRate The baud rate, or 0 if unknown.
      */
-    void setCommandTimeout(uint32_t timeout);
+    void setBaudRate(uint32_t baudRate);
     /**
-     * @brief Get the command timeout
-     *
-     * By default, this is #MODBUS_TIMEOUT (500 milliseconds).
+     * @brief Get the baud rate the stream was begun at
      *
-     * @return The command timeout value in milliseconds.
+     * @return The baud rate, or 0 if unknown.
      */
-    uint32_t getCommandTimeout();
+    uint32_t getBaudRate();
     /**
-     * @brief Set the frame timeout - the time to wait between characters within a frame
-     * (in ms)
-     *
-     * The modbus protocol defines that there can be no more than 1.5 characters of
-     * silence between characters in a frame and any space over 3.5 characters defines a
-     * new frame.
+     * @brief Set the direction control timing of the RS485 driver
      *
-     * By default, this is #MODBUS_FRAME_TIMEOUT (4 milliseconds).
+     * Use these to calibrate the direction switching for a board: the settle time
+     * covers the transceiver turning on before the first start bit, the hold time
+     * keeps it on after the last stop bit for adapters that need it.  Neither is used
+     * without an enable pin.
      *
-     * @param timeout The timeout value in milliseconds.
+     * @param settleMicros The time to wait after enabling the driver (in µs). By
+     * default, this is #MODBUS_DRIVER_SETTLE.
+     * @param holdMicros The time to keep the driver on after the request has been sent
+     * (in µs).  By default, this is #MODBUS_DRIVER_HOLD.
      */
-    void setFrameTimeout(uint32_t timeout);
+    void setDriverTiming(uint16_t settleMicros, uint16_t holdMicros);
     /**
-     * @brief Get the frame timeout - the time to wait between characters within a frame
-     * (in ms)
+     * @brief Set whether the adapter echoes each request back
      *
-     * By default, this is #MODBUS_FRAME_TIMEOUT (4 milliseconds).
+     * Some half-duplex RS485 adapters receive everything they send.  With echo
+     * suppression on, the library reads the echo of each request and checks it against
+     * what was sent before waiting for the response.  An echo that differs or is cut
+     * short means another device was driving the bus at the same time; the attempt
+     * then fails with #BUS_COLLISION and is counted in getBusCollisionCount().
      *
-     * @return The frame timeout value in milliseconds.
+     * @param enable True if the adapter echoes requests.  By default, this is false.
      */
-    uint32_t getFrameTimeout();
-
+    void setEchoSuppression(bool enable);
     /**
-     * @brief Set the number of times to retry a command before giving up
-     *
-     * By default, this is 10.
+     * @brief Get whether the adapter echoes each request back
      *
-     * @param retries The number of times to retry a command before giving up
+     * @return True if echo suppression is on.
      */
-    void setCommandRetries(uint8_t retries);
+    bool getEchoSuppression();
     /**
-     * @brief Get the current number of times to retry a command before giving up
-     *
-     * By default, this is 10.
+     * @brief Get the number of requests whose echo did not match what was sent
+     *
+     * @return The number of bus collisions since the last reset.
+     */
+    uint32_t getBusCollisionCount();
+    /**
+     * @brief Reset the number of bus collisions to 0
+     */
+    void resetBusCollisionCount();
+    /**
+     * @brief Set whether to search damaged responses for a good frame
+     *
+     * Noise on a long cable can put stray bytes ahead of or behind a response, so the
+     * whole capture fails the slave ID or CRC check.  With recovery on, the library
+     * then looks through the capture for a frame from the right slave, for the right
+     * function, of a consistent length, and with a good CRC, and accepts it instead of
+     * retrying the request.  Recovered frames are counted in
+     * getRecoveredFrameCount().  Streaming reads are never recovered, since their
+     * values are handed out as they arrive.
+     *
+     * @param enable True to search damaged responses.  By default, this is true.
+     */
+    void setFrameRecovery(bool enable);
+    /**
+     * @brief Get whether damaged responses are searched for a good frame
+     *
+     * @return True if frame recovery is on.
+     */
+    bool getFrameRecovery();
+    /**
+     * @brief Get the number of responses recovered from a damaged capture
+     *
+     * @return The number of recovered frames since the last reset.
+     */
+    uint32_t getRecoveredFrameCount();
+    /**
+     * @brief Reset the number of recovered frames to 0
+     */
+    void resetRecoveredFrameCount();
+    /**
+     * @brief Set the timeout to wait for a response from a sensor after a modbus
+     * command.
+     *
+     * By default, this is #MODBUS_TIMEOUT (500 milliseconds).
+     *
+     * @param timeout The timeout value in milliseconds.
+     */
+    void setCommandTimeout(uint32_t timeout);
+    /**
+     * @brief Get the command timeout
+     *
+     * By default, this is #MODBUS_TIMEOUT (500 milliseconds).
+     *
+     * @return The command timeout value in milliseconds.
+     */
+    uint32_t getCommandTimeout();
+    /**
+     * @brief Set the frame timeout - the time to wait between characters within a frame
+     * (in ms)
+     *
+     * The modbus protocol defines that there can be no more than 1.5 characters of
+     * silence between characters in a frame and any space over 3.5 characters defines a
+     * new frame.
+     *
+     * By default, this is #MODBUS_FRAME_TIMEOUT (4 milliseconds).
+     *
+     * @param timeout The timeout value in milliseconds.
+     */
+    void setFrameTimeout(uint32_t timeout);
+    /**
+     * @brief Get the frame timeout - the time to wait between characters within a frame
+     * (in ms)
+     *
+     * By default, this is #MODBUS_FRAME_TIMEOUT (4 milliseconds).
+     *
+     * @return The frame timeout value in milliseconds.
+     */
+    uint32_t getFrameTimeout();
+
+    /**
+     * @brief Set the number of times to retry a command before giving up
+     *
+     * By default, this is 10.
+     *
+     * @param retries The number of times to retry a command before giving up
+     */
+    void setCommandRetries(uint8_t retries);
+    /**
+     * @brief Get the current number of times to retry a command before giving up
+     *
+     * By default, this is 10.
      *
      * @return The number of times to retry a command before giving up
      */
@@ -387,6 +1076,42 @@ class modbusMaster {
      * @return A pointer to the Arduino stream object used for communication.
      */
     Stream* getStream();
+    /**
+     * @brief Set the function used to wait for data from the stream
+     *
+     * By default, the library checks the stream once a millisecond while waiting for
+     * a response and continuously between the characters of a response.
+     *
+     * @param waitFunction The function to use; nullptr to restore the default.
+     */
+    void setDataWaitFunction(dataWaitFunction waitFunction) {
+        _dataWaitFunction = waitFunction;
+    }
+    /**
+     * @brief Set how to wait for a response to start arriving
+     *
+     * With #waitDelay, the first byte of a response is noticed up to a millisecond
+     * after it arrives; the other strategies notice it within one check of the stream.
+     * Between the characters of a response the library always checks continuously,
+     * calling the callback between checks with #waitYield or #waitSleep.  A function
+     * set with setDataWaitFunction() takes precedence over the strategy.
+     *
+     * @param strategy The #modbusWaitStrategy to use
+     * @param callback The function to call between checks with #waitYield or
+     * #waitSleep; without one, those strategies spin like #waitSpin.
+     */
+    void setWaitStrategy(modbusWaitStrategy strategy, waitCallback callback = nullptr) {
+        _waitStrategy = strategy;
+        _waitCallback = callback;
+    }
+    /**
+     * @brief Get how the library waits for a response to start arriving
+     *
+     * @return The current #modbusWaitStrategy.
+     */
+    modbusWaitStrategy getWaitStrategy() {
+        return _waitStrategy;
+    }
     /**@}*/
 
 
@@ -1325,12 +2050,16 @@ class modbusMaster {
     /**@}*/
 
 
+#ifndef MODBUSMASTER_NO_STRING
     // ===================================================================== //
     /**
      * @anchor String_functions
      * @name Functions to get and set Strings
      *
-     * @note These are for Arduino String objects, not simple character arrays.
+     * @note These are for Arduino String objects, not simple character arrays.  Each
+     * String is allocated on the heap; in long-running programs, prefer the
+     * @ref text_functions "text functions", which never use the heap.  These functions
+     * are left out if MODBUSMASTER_NO_STRING is defined.
      */
     // ===================================================================== //
     /**@{*/
@@ -1373,9 +2102,10 @@ class modbusMaster {
      * false.
      * @return True if the registers were successfully set, false if not.
      */
-    bool StringToRegister(int regNum, String value, bool forceMultiple = false);
-    /// @copydoc modbusMaster::StringToRegister(int, String, bool)
-    bool StringToHoldingRegister(int regNum, String value, bool forceMultiple = false) {
+    bool StringToRegister(int regNum, const String& value, bool forceMultiple = false);
+    /// @copydoc modbusMaster::StringToRegister(int, const String&, bool)
+    bool StringToHoldingRegister(int regNum, const String& value,
+                                 bool forceMultiple = false) {
         return StringToRegister(regNum, value, forceMultiple);
     }
 
@@ -1399,7 +2129,103 @@ class modbusMaster {
      * @param start_index The starting position of the byte in the response frame.
      * Optional with a default of 0.
      */
-    void StringToFrame(String value, byte* destFrame, int start_index = 0);
+    void StringToFrame(const String& value, byte* destFrame, int start_index = 0);
+    /**@}*/
+#endif  // MODBUSMASTER_NO_STRING
+
+
+    // ===================================================================== //
+    /**
+     * @anchor text_functions
+     * @name Functions to get and set text in fixed-size buffers
+     *
+     * @brief Functions to read and write text without using the heap.
+     *
+     * When reading, only printable ASCII characters (0x20-0x7E) are kept; any other
+     * bytes, including null padding, are skipped.  No more than bufferSize - 1
+     * characters are written and the text is always null terminated, so the buffer
+     * can never overflow.  Spaces are kept unless trimming is requested, in which case
+     * spaces at the start and end of the text are removed.
+     *
+     * When writing, the text fills a field of charLength characters.  If the text is
+     * shorter than the field, the rest of the field is filled with nulls.  If the field
+     * has an odd length, it is padded with a null to a whole register.
+     */
+    // ===================================================================== //
+    /**@{*/
+    /**
+     * @brief Get a group of input registers and copy the text in them into a buffer.
+     *
+     * @param regNum The number of the first of the registers of interest.
+     * @param charLength The number of characters in the registers. NOTE: There are
+     * *TWO* characters per register!
+     * @param buffer The buffer to copy the text into.
+     * @param bufferSize The size of the buffer, including space for the terminating
+     * null.
+     * @param trim True to remove spaces from the start and end of the text. Optional
+     * with a default value of false.
+     * @return The number of characters copied, not including the terminating null; 0
+     * if the registers could not be read.
+     */
+    uint16_t textFromInputRegister(int regNum, int charLength, char* buffer,
+                                   uint16_t bufferSize, bool trim = false) {
+        return textFromRegister(0x04, regNum, charLength, buffer, bufferSize, trim);
+    }
+    /**
+     * @brief Get a group of holding registers and copy the text in them into a buffer.
+     * @copydetails modbusMaster::textFromInputRegister(int, int, char*, uint16_t, bool)
+     */
+    uint16_t textFromHoldingRegister(int regNum, int charLength, char* buffer,
+                                     uint16_t bufferSize, bool trim = false) {
+        return textFromRegister(0x03, regNum, charLength, buffer, bufferSize, trim);
+    }
+    /**
+     * @brief Get a group of input or holding registers and copy the text in them into
+     * a buffer.
+     * @copydetails modbusMaster::textFromInputRegister(int, int, char*, uint16_t, bool)
+     * @param regType The register type; use 0x03 for a holding register (read/write) or
+     * 0x04 for an input register (read only)
+     */
+    uint16_t textFromRegister(byte regType, int regNum, int charLength, char* buffer,
+                              uint16_t bufferSize, bool trim = false);
+    /**
+     * @brief Set a series of holding registers to a null-terminated text.
+     *
+     * @param regNum The first of the registers of interest
+     * @param text The null-terminated text to set the registers to.
+     * @param charLength The number of characters in the registers; text past this is
+     * not written.
+     * @param forceMultiple Set the forceMultiple boolean flag to 'true' to force the
+     * use of the Modbus command for setting multiple resisters (0x10). This only
+     * applies if the field is two characters or less. Optional with a default value of
+     * false.
+     * @return True if the registers were successfully set, false if not.
+     */
+    bool textToRegister(int regNum, const char* text, int charLength,
+                        bool forceMultiple = false);
+    /// @copydoc modbusMaster::textToRegister(int, const char*, int, bool)
+    bool textToHoldingRegister(int regNum, const char* text, int charLength,
+                               bool forceMultiple = false) {
+        return textToRegister(regNum, text, charLength, forceMultiple);
+    }
+    /**
+     * @brief Read text out of a modbus response frame into a buffer.
+     *
+     * @param charLength The number of characters in the frame.
+     * @param buffer The buffer to copy the text into.
+     * @param bufferSize The size of the buffer, including space for the terminating
+     * null.
+     * @param trim True to remove spaces from the start and end of the text. Optional
+     * with a default value of false.
+     * @param start_index The starting position of the characters in the response
+     * frame. Optional with a default of 3.
+     * @param sourceFrame The byte array to read from.  Optional with a default of the
+     * built in response buffer.
+     * @return The number of characters copied, not including the terminating null.
+     */
+    uint16_t textFromFrame(int charLength, char* buffer, uint16_t bufferSize,
+                           bool trim = false, int start_index = 3,
+                           byte* sourceFrame = responseBuffer);
     /**@}*/
 
 
@@ -1622,6 +2448,39 @@ class modbusMaster {
      */
     int16_t getDiscreteInputs(int16_t startInput, int16_t numInputs,
                               byte* buff = responseBuffer);
+
+    /**
+     * @brief Get data from either holding or input registers without copying it.
+     *
+     * @remark No more than 125 registers can be read at once.
+     *
+     * @param readCommand The command to use to read data. For a holding register
+     * readCommand = 0x03. For an input register readCommand = 0x04.
+     * @param startRegister The starting register number.
+     * @param numRegisters The number of registers to read.
+     * @return A view of the register data in the response buffer; the view is empty
+     * if the read failed. See modbusFrameView for how long the view stays valid.
+     */
+    modbusFrameView getRegisterView(byte readCommand, int16_t startRegister,
+                                    int16_t numRegisters);
+    /**
+     * @brief Get the data from a range of output coils without copying it.
+     *
+     * @param startCoil The starting coil number.
+     * @param numCoils The number of coils to read.
+     * @return A view of the coil data in the response buffer; the view is empty if the
+     * read failed. See modbusFrameView for how long the view stays valid.
+     */
+    modbusFrameView getCoilView(int16_t startCoil, int16_t numCoils);
+    /**
+     * @brief Get a range of discrete inputs without copying them.
+     *
+     * @param startInput The starting input number.
+     * @param numInputs The number of discrete inputs to read.
+     * @return A view of the input data in the response buffer; the view is empty if the
+     * read failed. See modbusFrameView for how long the view stays valid.
+     */
+    modbusFrameView getDiscreteInputView(int16_t startInput, int16_t numInputs);
     /**@}*/
 
 
@@ -1684,6 +2543,8 @@ class modbusMaster {
      *
      * @note This function always uses Modbus command 0x0F
      *
+     * @remark No more than 1968 coils can be set at once.
+     *
      * @param startCoil The address of the first coil to set.
      * @param numCoils The number of coils to set.
      * @param value A pointer to a byte array containing the values to set the coils to.
@@ -1694,6 +2555,111 @@ class modbusMaster {
     /**@}*/
 
 
+    // ===================================================================== //
+    /**
+     * @anchor block_functions
+     * @name Block transfer functions
+     *
+     * @brief Functions to read or write any number of registers or coils.
+     *
+     * These split the transfer into the fewest requests the modbus specifications and
+     * the library buffers allow and move the data for each request straight to or from
+     * the caller's buffer.  Each request is retried like any other command.
+     *
+     * If a request fails, the transfer stops there.  The return value is the number of
+     * registers or coils, counted from the start address, that were transferred before
+     * the failure; call getLastError() to find out why the rest was not.
+     *
+     * Coil and discrete input data is packed 8 to a byte, least significant bit first,
+     * exactly as it is in a modbus frame; the buffer must hold (count + 7) / 8 bytes.
+     * Register data is two bytes per register in the order the slave sends it.
+     */
+    // ===================================================================== //
+    /**@{*/
+    /**
+     * @brief Read any number of holding or input registers.
+     *
+     * @param readCommand The command to use to read data. For a holding register
+     * readCommand = 0x03. For an input register readCommand = 0x04.
+     * @param startRegister The first register to read.
+     * @param numRegisters The number of registers to read.
+     * @param buff The buffer to copy the register data into; it must hold at least
+     * numRegisters * 2 bytes.
+     * @return The number of registers read.
+     */
+    uint16_t getRegisterBlock(byte readCommand, uint16_t startRegister,
+                              uint16_t numRegisters, byte* buff);
+    /**
+     * @brief Read any number of output coils.
+     *
+     * @param startCoil The first coil to read.
+     * @param numCoils The number of coils to read.
+     * @param buff The buffer to copy the coil data into; it must hold at least
+     * (numCoils + 7) / 8 bytes.
+     * @return The number of coils read.
+     */
+    uint16_t getCoilBlock(uint16_t startCoil, uint16_t numCoils, byte* buff);
+    /**
+     * @brief Read any number of discrete inputs.
+     *
+     * @param startInput The first input to read.
+     * @param numInputs The number of inputs to read.
+     * @param buff The buffer to copy the input data into; it must hold at least
+     * (numInputs + 7) / 8 bytes.
+     * @return The number of inputs read.
+     */
+    uint16_t getDiscreteInputBlock(uint16_t startInput, uint16_t numInputs,
+                                   byte* buff);
+    /**
+     * @brief Write any number of holding registers.
+     *
+     * @param startRegister The first register to write.
+     * @param numRegisters The number of registers to write.
+     * @param value A pointer to the byte array with the values to write.
+     * @param forceMultiple Set to true to use command 0x10 even for a request that
+     * only writes a single register. Optional with a default value of false.
+     * @return The number of registers written.
+     */
+    uint16_t setRegisterBlock(uint16_t startRegister, uint16_t numRegisters,
+                              byte* value, bool forceMultiple = false);
+    /**
+     * @brief Write any number of output coils.
+     *
+     * @param startCoil The first coil to write.
+     * @param numCoils The number of coils to write.
+     * @param value A pointer to a byte array containing the values to set the coils to.
+     * @return The number of coils written.
+     */
+    uint16_t setCoilBlock(uint16_t startCoil, uint16_t numCoils, byte* value);
+
+    /**
+     * @brief Read any number of holding or input registers, handing each value to a
+     * handler as it arrives instead of copying the data.
+     *
+     * Like the other block functions, the read is split into the fewest legal requests.
+     * Within each request, the handler's element() function is called as soon as all
+     * of the bytes of a value have arrived.  When the request is finished, the values
+     * are either committed (good frame and CRC) or rolled back (anything else; the
+     * request may then be retried).  See modbusElementHandler.
+     *
+     * @param readCommand The command to use to read data. For a holding register
+     * readCommand = 0x03. For an input register readCommand = 0x04.
+     * @param startRegister The first register to read.
+     * @param numRegisters The number of registers to read.  For 4 byte values, this
+     * must be even.
+     * @param handler The handler to receive the values.
+     * @param elementBytes The size of each value: 2 for 16-bit values (one register) or
+     * 4 for 32-bit values (two registers). Optional with a default value of 2.
+     * @param endian The endianness of the values in the modbus registers. Optional
+     * with a default value of big endian, which is specified by modbus.
+     * @return The number of registers read and committed.
+     */
+    uint16_t streamRegisters(byte readCommand, uint16_t startRegister,
+                             uint16_t numRegisters, modbusElementHandler& handler,
+                             uint8_t elementBytes = 2, endianness endian = bigEndian);
+    /**@}*/
+
+
     // ===================================================================== //
     /**
      * @anchor low_level_functions
@@ -1735,9 +2701,36 @@ class modbusMaster {
      * @return Zero if the response didn't return the expected number of bytes or if
      * there was an error in the modbus response; otherwise, the number of bytes in the
      * response.
+     *
+     * @note When the size is calculated, numChunks must be between 1 and the most
+     * that can be read at once (2000 coils or inputs or 125 registers, or fewer if the
+     * response buffer is small).  Larger requests are not sent; they return zero with
+     * the last error set to #ILLEGAL_DATA_VALUE, which is what the slave would have
+     * answered.  Use the @ref block_functions "block transfer functions" for larger
+     * reads.
      */
     int16_t getModbusData(byte slaveId, byte readCommand, int16_t startAddress,
                           int16_t numChunks, uint8_t expectedReturnBytes = 0);
+    /**
+     * @brief Send a prepared read request, retrying as needed
+     *
+     * The request goes to the slave it was prepared for, not the slave ID of this
+     * object.  The data is left in the response buffer, as for the other
+     * getModbusData().
+     *
+     * @param request The prepared request
+     * @return Zero if the request is not prepared, the response didn't return the
+     * expected number of bytes, or there was an error in the modbus response;
+     * otherwise, the number of data bytes in the response.
+     */
+    int16_t getModbusData(const modbusPreparedRequest& request);
+    /**
+     * @brief Send a prepared read request and get a view of the data
+     *
+     * @param request The prepared request
+     * @return A view of the data; an empty view if the read failed.
+     */
+    modbusFrameView getPreparedView(const modbusPreparedRequest& request);
 
     /**
      * @brief Send a command to the modbus slave.
@@ -1765,6 +2758,28 @@ class modbusMaster {
      * @return The number of bytes received from the Modbus slave.
      */
     uint16_t sendCommand(byte* command, int commandLength);
+    /**
+     * @brief Send a frame that already has its CRC to the modbus slave.
+     *
+     * This is the same as sendCommand(), except that the frame is sent as is, without
+     * calculating and adding the CRC.
+     *
+     * @param frame The complete frame to send, including the CRC.
+     * @param frameLength The length of the frame, including the CRC.
+     * @return The number of bytes received from the Modbus slave.
+     */
+    uint16_t sendFrame(const byte* frame, int frameLength);
+    /**
+     * @brief Send a frame built by the constexpr frame builders to the modbus slave.
+     *
+     * @tparam N The length of the frame, including the CRC
+     * @param frame The complete frame; see SensorModbusFrames.h.
+     * @return The number of bytes received from the Modbus slave.
+     */
+    template <uint16_t N>
+    uint16_t sendFrame(const modbusFrame<N>& frame) {
+        return sendFrame(frame.data, N);
+    }
     /**@}*/
 
     // ===================================================================== //
@@ -1821,6 +2836,395 @@ class modbusMaster {
     void printLastError(void);
     /**@}*/
 
+    // ===================================================================== //
+    /**
+     * @anchor timing_functions
+     * @name Timing functions
+     *
+     * Functions to see when requests were sent and answered.
+     */
+    // ===================================================================== //
+    /**@{*/
+    /**
+     * @brief Get the timing of the last transaction
+     *
+     * Every request sent, including each retry, replaces the timing, so call this
+     * immediately after the command.  The views returned by getRegisterView(),
+     * getCoilView(), and getDiscreteInputView() carry a copy of the timing of the
+     * transaction their data came from.
+     *
+     * @return The timing of the last transaction.
+     */
+    const modbusTiming& getLastTiming(void) const {
+        return _timing;
+    }
+    /**@}*/
+
+    // ===================================================================== //
+    /**
+     * @anchor circuit_breaker_functions
+     * @name Circuit breaker functions
+     *
+     * Functions to stop unresponsive slaves from stalling the bus.
+     *
+     * When the circuit breaker is enabled, a slave that gives no response to a number
+     * of consecutive requests has its circuit opened. Any further requests to that
+     * slave fail immediately with #NO_RESPONSE without anything being sent. Once the
+     * backoff time has passed, the next request to the slave is sent once as a probe
+     * (the circuit is half open). If the slave answers the circuit is closed again;
+     * otherwise it is re-opened and the backoff time is doubled.
+     *
+     * Any answer from the slave - including an exception or a response with a bad CRC -
+     * counts as a response.
+     */
+    // ===================================================================== //
+    /**@{*/
+    /**
+     * @brief Enable or disable the circuit breaker.
+     *
+     * By default, the circuit breaker is disabled.
+     *
+     * @param failureThreshold The number of consecutive requests with no response
+     * before a slave's circuit is opened. Use 0 to disable the circuit breaker.
+     * @param backoff The time to wait before the first probe of a slave whose circuit
+     * has opened (in ms). Optional with a default of #MODBUS_CIRCUIT_BACKOFF.
+     * @param maxBackoff The maximum time to wait between probes (in ms). Optional with
+     * a default of #MODBUS_CIRCUIT_MAX_BACKOFF.
+     */
+    void setCircuitBreaker(uint8_t failureThreshold,
+                           uint32_t backoff    = MODBUS_CIRCUIT_BACKOFF,
+                           uint32_t maxBackoff = MODBUS_CIRCUIT_MAX_BACKOFF);
+    /**
+     * @brief Get the number of consecutive requests with no response before a slave's
+     * circuit is opened.
+     *
+     * @return The circuit breaker failure threshold; 0 if the circuit breaker is
+     * disabled.
+     */
+    uint8_t getCircuitBreakerThreshold();
+    /**
+     * @brief Set a function to be called whenever the circuit state of a slave
+     * changes.
+     *
+     * @param callback The function to call; use nullptr to remove the callback.
+     */
+    void setCircuitStateCallback(circuitStateCallback callback) {
+        _circuitCallback = callback;
+    }
+    /**
+     * @brief Get the circuit state of a slave on this object's stream.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @return The circuit state of the slave. Slaves that are not being tracked are
+     * always #circuitClosed.
+     */
+    circuitState getCircuitState(byte slaveID);
+    /**
+     * @brief Close the circuit of a slave on this object's stream and forget its
+     * failure history.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     */
+    void resetCircuit(byte slaveID);
+    /**@}*/
+
+    // ===================================================================== //
+    /**
+     * @anchor discovery_functions
+     * @name Device discovery functions
+     *
+     * Functions to find which slaves are present on the bus and identify them.
+     *
+     * The probes used by these functions are only tried once and use the discovery
+     * timeout (#MODBUS_DISCOVERY_TIMEOUT by default) instead of the command timeout.
+     * The circuit breaker is bypassed while probing. The results are cached by slave
+     * ID and can be retrieved later with getDeviceInfo(byte).
+     */
+    // ===================================================================== //
+    /**@{*/
+    /**
+     * @brief Set the time to wait for a response to a discovery probe.
+     *
+     * By default, this is #MODBUS_DISCOVERY_TIMEOUT (30 milliseconds).
+     *
+     * @param timeout The timeout value in milliseconds.
+     */
+    void setDiscoveryTimeout(uint32_t timeout);
+    /**
+     * @brief Get the time to wait for a response to a discovery probe.
+     *
+     * @return The discovery timeout value in milliseconds.
+     */
+    uint32_t getDiscoveryTimeout();
+    /**
+     * @brief Check whether a slave is present by sending it a single Report Server ID
+     * (0x11) request.
+     *
+     * Any valid answer from the slave - including an exception - means that it is
+     * present. If the slave does support Report Server ID, the result is cached.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @return True if the slave answered.
+     */
+    bool probeSlave(byte slaveID);
+    /**
+     * @brief Probe a range of slave IDs and identify every slave that answers.
+     *
+     * Each address is probed with a single Report Server ID (0x11) request. Each slave
+     * that answers is then asked for its basic Read Device Identification (0x2B / 0x0E)
+     * objects. The results are cached.
+     *
+     * @param firstID The first slave ID to probe. Optional with a default of 1.
+     * @param lastID The last slave ID to probe. Optional with a default of 247.
+     * @param callback A function to call for each device found. Optional.
+     * @return The number of slaves found.
+     */
+    uint8_t discoverSlaves(byte firstID = 1, byte lastID = 247,
+                           discoveryCallback callback = nullptr);
+    /**
+     * @brief Get the data returned by a Report Server ID (0x11) request and cache it.
+     *
+     * This uses the normal command timeout and retries.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @return True if the slave returned its server ID.
+     */
+    bool reportServerID(byte slaveID);
+    /**
+     * @brief Get the basic device identification objects (vendor name, product code,
+     * and revision) with Read Device Identification (0x2B / 0x0E) requests and cache
+     * them.
+     *
+     * This uses the normal command timeout and retries.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @return True if the slave returned its identification.
+     */
+    bool readDeviceIdentification(byte slaveID);
+    /**
+     * @brief Get the cached identification of a slave on this object's stream.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @return A pointer to the cached identification, or nullptr if nothing is cached
+     * for the slave. The pointer stays valid until the cache entry is reused.
+     */
+    const modbusDeviceInfo* getDeviceInfo(byte slaveID);
+    /**
+     * @brief Forget all cached device identification.
+     */
+    void clearDeviceCache();
+    /**@}*/
+
+    // ===================================================================== //
+    /**
+     * @anchor register_map_functions
+     * @name Register map functions
+     *
+     * Functions to find which addresses of a slave can be read when no register map is
+     * available.
+     */
+    // ===================================================================== //
+    /**@{*/
+    /**
+     * @brief Find the readable ranges of addresses of one type.
+     *
+     * This reads the largest blocks the protocol allows and only splits a block in half
+     * when the slave rejects it with an illegal data address (or illegal data value)
+     * exception. Halves are split again until every rejected address has been found.
+     * A few rejected addresses in a block of n cost about 2 * log2(n) requests each.
+     *
+     * Splitting a block that is rejected throughout costs almost twice as many
+     * requests as reading it one address at a time, so rejected blocks of up to
+     * #MODBUS_MAP_SCAN_SIZE addresses, and a rejected upper half whose lower half was
+     * rejected in both of its own halves, are read one address at a time instead.
+     * When nearly every address is rejected, mapping takes about one request per
+     * address plus two for each time a block is halved.  The worst case is a block of
+     * n with rejected addresses in both quarters of its lower half and one more in its
+     * upper half: the upper half is then read one address at a time, about n / 2
+     * requests where bisection alone would need about 2 * log2(n).
+     *
+     * Adjacent readable ranges are merged, and the ranges are returned in ascending
+     * order.
+     *
+     * Mapping stops early if the slave stops responding, rejects the read command
+     * itself, or there is no more room for ranges. Check getLastError() to see why
+     * mapping stopped; it is #NO_ERROR if the whole range was mapped.
+     *
+     * @param readCommand The command to use to read data. For a coil readCommand =
+     * 0x01, for a discrete input readCommand = 0x02, for a holding register
+     * readCommand = 0x03, and for an input register readCommand = 0x04.
+     * @param firstAddress The first address to check.
+     * @param lastAddress The last address to check.
+     * @param ranges An array to fill with the readable ranges.
+     * @param maxRanges The number of ranges the array can hold.
+     * @return The number of ranges found.
+     */
+    uint8_t mapRegisters(byte readCommand, uint16_t firstAddress, uint16_t lastAddress,
+                         modbusRegisterRange* ranges, uint8_t maxRanges);
+    /**@}*/
+
+    // ===================================================================== //
+    /**
+     * @anchor serial_detection_functions
+     * @name Serial setting detection functions
+     *
+     * Functions to find the baud rate and parity a slave uses.
+     */
+    // ===================================================================== //
+    /**@{*/
+    /**
+     * @brief Find the baud rate and parity a slave is using.
+     *
+     * The port is restarted with each candidate setting in turn and a single request
+     * to read holding register 0 is sent to the slave. The first setting that gets a
+     * correctly addressed response with a good CRC - whether data or an exception - is
+     * the one the slave is using. The port is left running with that setting and it
+     * becomes this object's stream.
+     *
+     * The probe timeout at each baud rate is the time to send the probe and the first
+     * byte of the response plus #MODBUS_DETECT_TURNAROUND, so trying all of the default
+     * candidates takes well under a second. The command and frame timeouts, the
+     * number of retries, and the circuit breaker are restored afterwards.
+     *
+     * If no candidates are given, these are tried, most common first: 9600 8N1, 19200
+     * 8E1 (the modbus default), 9600 8E1, 19200 8N1, 38400 8N1, 115200 8N1, 4800 8N1,
+     * 57600 8N1, 9600 8N2, 9600 8O1, 38400 8E1, and 2400 8N1.
+     *
+     * @tparam SerialType A serial port class with a `begin(baudRate, config)` and an
+     * `end()` function, like HardwareSerial.
+     * @param port The serial port the slave is connected to.
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @param result The setting that worked, if any.
+     * @param candidates An array of settings to try, in order. Optional; if omitted,
+     * the default list is used.
+     * @param numCandidates The number of settings in the candidates array.
+     * @return True if a working setting was found.
+     *
+     * @note The default list needs the core to define SERIAL_8N1, SERIAL_8E1,
+     * SERIAL_8O1, and SERIAL_8N2; otherwise candidates must be given.
+     */
+    template <typename SerialType>
+    bool detectSerialConfig(SerialType& port, byte slaveID, modbusSerialConfig& result,
+                            const modbusSerialConfig* candidates    = nullptr,
+                            uint8_t                   numCandidates = 0) {
+#if defined(SERIAL_8N1) && defined(SERIAL_8E1) && defined(SERIAL_8O1) && \
+    defined(SERIAL_8N2)
+        static const modbusSerialConfig defaultCandidates[] = {
+            {9600, SERIAL_8N1},  {19200, SERIAL_8E1}, {9600, SERIAL_8E1},
+            {19200, SERIAL_8N1}, {38400, SERIAL_8N1}, {115200, SERIAL_8N1},
+            {4800, SERIAL_8N1},  {57600, SERIAL_8N1}, {9600, SERIAL_8N2},
+            {9600, SERIAL_8O1},  {38400, SERIAL_8E1}, {2400, SERIAL_8N1}};
+        if (candidates == nullptr) {
+            candidates    = defaultCandidates;
+            numCandidates = sizeof(defaultCandidates) / sizeof(defaultCandidates[0]);
+        }
+#endif
+        if (candidates == nullptr) { return false; }
+
+        uint32_t oldTimeout      = modbusTimeout;
+        uint32_t oldFrameTimeout = modbusFrameTimeout;
+        uint8_t  oldRetries      = commandRetries;
+        uint8_t  oldThreshold    = circuitThreshold;
+        commandRetries           = 1;
+        circuitThreshold         = 0;
+        setStream(port);
+
+        bool found = false;
+        for (uint8_t i = 0; i < numCandidates && !found; i++) {
+            port.end();
+            port.begin(candidates[i].baudRate, candidates[i].config);
+            setBaudRate(candidates[i].baudRate);
+            // The probe is 8 bytes; wait for it and the first byte of the response
+            modbusTimeout = (9 * charTimeMicros(candidates[i].baudRate) + 999) / 1000 +
+                MODBUS_DETECT_TURNAROUND;
+            setFrameTimeout(frameTimeoutForBaud(candidates[i].baudRate));
+            debugPrint(F("Trying "), candidates[i].baudRate, F(" baud with config "),
+                       candidates[i].config, '\n');
+
+            getModbusData(slaveID, 0x03, 0, 1);
+            // Any correctly addressed answer with a good CRC - even an exception -
+            // means the setting is right
+            if (lastError == NO_ERROR || (static_cast<int8_t>(lastError) > 0 &&
+                                          static_cast<int8_t>(lastError) < 0x0C)) {
+                result = candidates[i];
+                found  = true;
+            }
+        }
+
+        modbusTimeout    = oldTimeout;
+        commandRetries   = oldRetries;
+        circuitThreshold = oldThreshold;
+        setFrameTimeout(oldFrameTimeout);
+        return found;
+    }
+
+    /**
+     * @brief Get the time it takes to send a single character at a baud rate.
+     *
+     * This assumes 11 bits per character: a start bit, 8 data bits, a parity or stop
+     * bit and a stop bit.
+     *
+     * @param baudRate The baud rate.
+     * @return The time to send one character, in microseconds (rounded up).
+     */
+    static uint32_t charTimeMicros(uint32_t baudRate) {
+        return (11000000UL + baudRate - 1) / baudRate;
+    }
+    /**
+     * @brief Get a frame timeout suitable for a baud rate.
+     *
+     * This is the 3.5 character silence that ends a modbus frame, rounded up to whole
+     * milliseconds with an extra millisecond to allow for the resolution of millis().
+     *
+     * @param baudRate The baud rate.
+     * @return The frame timeout, in milliseconds.
+     */
+    static uint32_t frameTimeoutForBaud(uint32_t baudRate) {
+        return (7 * charTimeMicros(baudRate) / 2 + 999) / 1000 + 1;
+    }
+    /**@}*/
+
+    // ===================================================================== //
+    /**
+     * @anchor crc_functions
+     * @name CRC functions
+     *
+     * @brief Functions to calculate the modbus RTU CRC-16.
+     *
+     * The CRC is sent low byte first at the end of each frame.
+     */
+    // ===================================================================== //
+    /**@{*/
+    /**
+     * @brief Add one byte to a running modbus CRC.
+     *
+     * Start a new CRC at 0xFFFF.
+     *
+     * @param crc The CRC of the bytes before this one.
+     * @param value The next byte.
+     * @return The CRC including the new byte.
+     */
+    static uint16_t crcUpdate(uint16_t crc, byte value) {
+        crc ^= value;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 0x0001) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+        return crc;
+    }
+    /**
+     * @brief Calculate the modbus CRC of a run of bytes.
+     *
+     * @param data The bytes to calculate the CRC of.
+     * @param length The number of bytes.
+     * @return The CRC.
+     */
+    static uint16_t crc16(const byte* data, uint16_t length) {
+        uint16_t crc = 0xFFFF;
+        for (uint16_t i = 0; i < length; i++) { crc = crcUpdate(crc, data[i]); }
+        return crc;
+    }
+    /**@}*/
+
     // ===================================================================== //
     /**
      * @anchor internal_buffers
@@ -1845,6 +3249,8 @@ class modbusMaster {
     //----------------------------------------------------------------------------
 
  private:
+    // Prepared requests use the same limits on the number of values read
+    friend class modbusPreparedRequest;
 
     /**
      * @brief This flips the device/receive enable to DRIVER so the arduino can send
@@ -1855,8 +3261,32 @@ class modbusMaster {
     /**
      * @brief This flips the device/receive enable to RECEIVER so the sensor can send
      * text
+     *
+     * If the baud rate is known, this first waits until the whole request has had time
+     * to be sent.
+     *
+     * @param frameLength The length of the request just sent.
+     */
+    void receiverEnable(int frameLength);
+
+    /**
+     * @brief Read and check the echo of a request
+     *
+     * @param frame The request that was sent.
+     * @param frameLength The length of the request.
+     * @return True if the whole request came back unchanged.
+     */
+    bool consumeEcho(const byte* frame, int frameLength);
+    /**
+     * @brief Search the response buffer for a good response to a request
+     *
+     * If one is found, it is moved to the start of the buffer.
+     *
+     * @param command The request that was sent.
+     * @param bytesRead The number of bytes in the response buffer.
+     * @return The length of the frame found, or 0 if there is none.
      */
-    void receiverEnable(void);
+    int recoverFrame(const byte* command, int bytesRead);
 
     /**
      * @brief This empties the serial buffer
@@ -1871,7 +3301,7 @@ class modbusMaster {
      * @param modbusFrame The modbus frame to print
      * @param frameLength The length of the frame to print
      */
-    void printFrameHex(byte* modbusFrame, int frameLength);
+    void printFrameHex(const byte* modbusFrame, int frameLength);
 
     /**
      * @brief Calculates a Modbus RTC cyclical redundancy code (CRC)
@@ -1889,6 +3319,35 @@ class modbusMaster {
      */
     void insertCRC(byte* modbusFrame, int frameLength);
 
+    /**
+     * @brief Read a response into the response buffer one byte at a time until the
+     * frame timeout passes with no new bytes or the buffer is full.
+     *
+     * If a streaming read is in progress, this also hands each complete value of the
+     * response to the handler as it arrives.
+     *
+     * @param slaveID The slave the response should come from.
+     * @param crc Set to the CRC of all of the bytes read except the last two.
+     * @return The number of bytes read.
+     */
+    int receiveFrame(byte slaveID, uint16_t& crc);
+    /**
+     * @brief Wait for the stream to have data to read
+     *
+     * @param timeout The longest time to wait (in ms).
+     * @param spin True to check the stream continuously even with #waitDelay, ie,
+     * between the characters of a response.
+     * @return True if the stream has data to read.
+     */
+    bool waitForData(uint32_t timeout, bool spin);
+    /**
+     * @brief Commit or roll back the values handed to the streaming handler for the
+     * current request.
+     *
+     * @param good True if the values should be committed.
+     */
+    void finishStream(bool good);
+
     /**
      * @brief This slices one array out of another
      *
@@ -1920,6 +3379,121 @@ class modbusMaster {
     leFrame leFrameFromFrame(int varLength, endianness endian = bigEndian,
                              int start_index = 3, byte* sourceFrame = responseBuffer);
 
+    /**
+     * @brief Find the health record of a slave on this object's stream.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @param create True to claim a table entry for the slave if it does not have one.
+     * @return A pointer to the slave's health record, or nullptr if the slave is not
+     * tracked (and no entry could be claimed).
+     */
+    slaveHealth* findSlaveHealth(byte slaveID, bool create = false);
+    /**
+     * @brief Check whether a request may be sent to a slave, given the state of its
+     * circuit.
+     *
+     * If the circuit is open and the backoff time has passed, this moves the circuit to
+     * half open and allows the request through as the probe.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @return True if the request should be sent.
+     */
+    bool circuitAllowsRequest(byte slaveID);
+    /**
+     * @brief Update the circuit state of a slave after a request.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @param responded True if anything at all was received from the slave.
+     */
+    void recordCircuitResult(byte slaveID, bool responded);
+    /**
+     * @brief Re-open a half open circuit whose probe never reached the slave.
+     *
+     * The probe is given up without counting it as a failure; the backoff time is
+     * restarted but not doubled.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     */
+    void abandonCircuitProbe(byte slaveID);
+    /**
+     * @brief Change the circuit state of a slave and notify the callback.
+     *
+     * @param health The slave's health record.
+     * @param newState The new circuit state.
+     */
+    void changeCircuitState(slaveHealth* health, circuitState newState);
+
+    /**
+     * @brief Find the cached identification of a slave on this object's stream.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @param create True to claim a cache entry for the slave if it does not have one.
+     * @return A pointer to the cache entry, or nullptr if there is none.
+     */
+    modbusDeviceInfo* findDeviceInfo(byte slaveID, bool create = false);
+    /**
+     * @brief Send a Report Server ID (0x11) request once and cache the result.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @return True if the slave returned its server ID.
+     */
+    bool requestServerID(byte slaveID);
+    /**
+     * @brief Send Read Device Identification (0x2B / 0x0E) requests until all basic
+     * objects have been read and cache the results.
+     *
+     * @param slaveID The byte identifier of the modbus slave device.
+     * @return True if the slave returned its identification.
+     */
+    bool requestDeviceIdentification(byte slaveID);
+
+    /**
+     * @brief Get the largest number of coils, discrete inputs, or registers that can be
+     * read with a single command.
+     *
+     * This is the smaller of the limit set by the modbus specifications and the limit
+     * set by the size of the response buffer.
+     *
+     * @param readCommand The command used to read data.
+     * @return The maximum number of chunks to request; 0 if the command is not a read
+     * command.
+     */
+    static uint16_t maxReadChunks(byte readCommand);
+    /**
+     * @brief Send a complete read request frame, retrying as needed, and check that
+     * the response holds the expected number of data bytes
+     *
+     * @param frame The complete 8 byte request frame, including the CRC.
+     * @param expectedReturnBytes The number of data bytes a good response holds.
+     * @return The number of data bytes; zero if the read failed.
+     */
+    int16_t readFrame(const byte* frame, uint8_t expectedReturnBytes);
+    /**
+     * @brief Get the largest number of coils or registers that can be written with a
+     * single command.
+     *
+     * This is the smaller of the limit set by the modbus specifications and the limit
+     * set by the size of the command buffer.
+     *
+     * @param writeCommand The command used to write data; 0x0F for coils or 0x10 for
+     * holding registers.
+     * @return The maximum number of chunks to write; 0 if the command is not a
+     * multiple write command.
+     */
+    uint16_t maxWriteChunks(byte writeCommand);
+    /**
+     * @brief Read a block of coils, discrete inputs, or registers of any size, split
+     * into as few legal requests as possible.
+     *
+     * @param readCommand The command used to read data.
+     * @param startAddress The first address to read.
+     * @param numChunks The number of coils, inputs, or registers to read.
+     * @param buff The buffer to copy the data into.
+     * @return The number of coils, inputs, or registers read.
+     */
+    uint16_t getDataBlock(byte readCommand, uint16_t startAddress, uint16_t numChunks,
+                          byte* buff);
+
     // Utility templates for writing to the debugging stream
     template <typename T>
     inline void debugPrint(T last) {
@@ -1945,6 +3519,34 @@ class modbusMaster {
      * if applicable.
      */
     int8_t _enablePin;
+    /**
+     * @brief The baud rate the stream was begun at; 0 if unknown
+     */
+    uint32_t _baudRate = 0;
+    /**
+     * @brief The time to wait after enabling the RS485 driver (in µs)
+     */
+    uint16_t _driverSettle = MODBUS_DRIVER_SETTLE;
+    /**
+     * @brief The time to keep the RS485 driver on after sending (in µs)
+     */
+    uint16_t _driverHold = MODBUS_DRIVER_HOLD;
+    /**
+     * @brief True if the adapter echoes each request back
+     */
+    bool _echoSuppression = false;
+    /**
+     * @brief The number of requests whose echo did not match what was sent
+     */
+    uint32_t _busCollisions = 0;
+    /**
+     * @brief True to search damaged responses for a good frame
+     */
+    bool _frameRecovery = true;
+    /**
+     * @brief The number of responses recovered from a damaged capture
+     */
+    uint32_t _recoveredFrames = 0;
     /**
      * @brief The stream instance (serial port) for debugging
      */
@@ -1978,6 +3580,87 @@ class modbusMaster {
      */
     modbusErrorCode lastError = NO_ERROR;
 
+    /**
+     * @brief The timing of the last transaction
+     */
+    modbusTiming _timing = modbusTiming();
+
+    /**
+     * @brief The number of consecutive requests with no response before a slave's
+     * circuit is opened; 0 if the circuit breaker is disabled.
+     */
+    uint8_t circuitThreshold = 0;
+    /**
+     * @brief The time to wait before the first probe of an open circuit (in ms)
+     */
+    uint32_t circuitBackoff = MODBUS_CIRCUIT_BACKOFF;
+    /**
+     * @brief The maximum time to wait between probes of an open circuit (in ms)
+     */
+    uint32_t circuitMaxBackoff = MODBUS_CIRCUIT_MAX_BACKOFF;
+    /**
+     * @brief The function to call when the circuit state of a slave changes
+     */
+    circuitStateCallback _circuitCallback = nullptr;
+    /**
+     * @brief The health records of slaves tracked by the circuit breaker.
+     */
+    static slaveHealth healthTable[MODBUS_HEALTH_TABLE_SIZE];
+
+    /**
+     * @brief The time to wait for a response to a discovery probe (in ms)
+     */
+    uint32_t discoveryTimeout = MODBUS_DISCOVERY_TIMEOUT;
+    /**
+     * @brief The cached identification of devices found by the discovery functions.
+     */
+    static modbusDeviceInfo deviceCache[MODBUS_DEVICE_CACHE_SIZE];
+    /**
+     * @brief The next device cache entry to reuse when the cache is full.
+     */
+    static uint8_t nextDeviceCacheEntry;
+
+    /**
+     * @brief The function used to wait for data; nullptr to check the stream directly
+     */
+    dataWaitFunction _dataWaitFunction = nullptr;
+    /**
+     * @brief How to wait for a response to start arriving
+     */
+    modbusWaitStrategy _waitStrategy = waitDelay;
+    /**
+     * @brief The function called between checks of the stream with #waitYield or
+     * #waitSleep
+     */
+    waitCallback _waitCallback = nullptr;
+
+    /**
+     * @brief The handler receiving values during a streaming read; nullptr if no
+     * streaming read is in progress.
+     */
+    modbusElementHandler* _streamHandler = nullptr;
+    /**
+     * @brief The size of each value of the streaming read in bytes
+     */
+    uint8_t _streamElementBytes = 2;
+    /**
+     * @brief The endianness of the values of the streaming read
+     */
+    endianness _streamEndian = bigEndian;
+    /**
+     * @brief The number of data bytes expected in each response of the streaming read
+     */
+    uint8_t _streamExpectedBytes = 0;
+    /**
+     * @brief The index of the first value of the current request of the streaming read
+     */
+    uint16_t _streamFirstElement = 0;
+    /**
+     * @brief The number of values handed to the handler since the last commit or
+     * rollback
+     */
+    uint16_t _streamPending = 0;
+
     /**
      * @brief print hex byte with padding
      *
@@ -0,0 +1,103 @@
+/**
+ * @file SensorModbusPoller.cpp
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusChangePoller class definitions.
+ */
+
+#include "SensorModbusPoller.h"
+
+modbusChangePoller::modbusChangePoller(modbusMaster& master, modbusPoint* points,
+                                       uint8_t numPoints)
+    : _master(master),
+      _points(points),
+      _numPoints(numPoints),
+      _callback(nullptr),
+      _keyframeInterval(0),
+      _pollsToKeyframe(0),
+      _keyframePending(true),
+      _failedCount(0) {
+    for (uint8_t i = 0; i < _numPoints; i++) { _points[i].reported = false; }
+}
+
+uint8_t modbusChangePoller::poll(void) {
+    // The most registers that fit in one response
+    const uint16_t maxRegisters = (RESPONSE_BUFFER_SIZE - 5) / 2 < 125
+        ? (RESPONSE_BUFFER_SIZE - 5) / 2
+        : 125;
+
+    // The first poll and forced keyframes don't depend on the interval; with an
+    // interval of 0 there is no countdown at all
+    bool keyframe = _keyframePending;
+    if (_keyframeInterval > 0) {
+        if (_pollsToKeyframe == 0) {
+            keyframe = true;
+        } else {
+            _pollsToKeyframe--;
+        }
+    }
+    if (keyframe) { _pollsToKeyframe = _keyframeInterval; }
+    _keyframePending = false;
+
+    uint8_t reportedCount = 0;
+    _failedCount          = 0;
+    uint8_t first         = 0;
+    while (first < _numPoints) {
+        // Gather the following points that can be read in the same request
+        const modbusPoint& head  = _points[first];
+        uint16_t           start = head.regNum;
+        uint16_t end  = start + modbusFrameView::registersFor(head.type);
+        uint8_t  last = first + 1;
+        while (last < _numPoints) {
+            const modbusPoint& next = _points[last];
+            uint16_t nextEnd = next.regNum + modbusFrameView::registersFor(next.type);
+            if (next.regType != head.regType || next.regNum < start ||
+                next.regNum > end + MODBUS_POLLER_MAX_GAP ||
+                (nextEnd > end ? nextEnd : end) - start > maxRegisters) {
+                break;
+            }
+            if (nextEnd > end) { end = nextEnd; }
+            last++;
+        }
+
+        modbusFrameView view =
+            _master.getRegisterView(head.regType, static_cast<int16_t>(start),
+                                    static_cast<int16_t>(end - start));
+        if (!view.valid()) {
+            _failedCount += last - first;
+            first = last;
+            continue;
+        }
+
+        for (uint8_t i = first; i < last; i++) {
+            modbusPoint& point = _points[i];
+            uint16_t     index = point.regNum - start;
+            float        value = view.numberAt(index, point.type, point.endian);
+            uint32_t     raw   = view.rawAt(index, point.type, point.endian);
+            if (!keyframe && point.reported && !changed(point, value, raw)) {
+                continue;
+            }
+            point.value    = value;
+            point.raw      = raw;
+            point.reported = true;
+            reportedCount++;
+            if (_callback != nullptr) { _callback(i, point, keyframe); }
+        }
+        first = last;
+    }
+    return reportedCount;
+}
+
+bool modbusChangePoller::changed(const modbusPoint& point, float value, uint32_t raw) {
+    if (point.changeMask != 0) { return ((raw ^ point.raw) & point.changeMask) != 0; }
+    if (raw == point.raw) { return false; }
+
+    // A change to or from NaN is always reported
+    if (isnan(value) || isnan(point.value)) { return true; }
+    float deadband = point.relativeDeadband * fabs(point.value);
+    if (point.absoluteDeadband > deadband) { deadband = point.absoluteDeadband; }
+    if (deadband <= 0) { return true; }
+    return fabs(value - point.value) > deadband;
+}
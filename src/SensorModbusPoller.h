@@ -0,0 +1,150 @@
+/**
+ * @file SensorModbusPoller.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusChangePoller class declarations.
+ */
+
+#ifndef SensorModbusPoller_h
+#define SensorModbusPoller_h
+
+#include "SensorModbusMaster.h"
+
+/**
+ * @brief The most registers a modbusChangePoller will skip over to read two points in
+ * one request
+ */
+#define MODBUS_POLLER_MAX_GAP 8
+
+/**
+ * @brief One value polled by a modbusChangePoller.
+ *
+ * Fill in the settings; the poller keeps the rest up to date.
+ *
+ * A value is reported when it moves further than its deadband from the value last
+ * reported: the larger of @ref absoluteDeadband and @ref relativeDeadband times the
+ * last value.  Because the comparison is with the last *reported* value, a slow drift
+ * is still reported once it adds up.  With both deadbands at 0, any change at all is
+ * reported.
+ *
+ * For status words and other bit fields, set a @ref changeMask instead; the value is
+ * then reported whenever any of the masked bits change and the deadbands are ignored.
+ */
+typedef struct modbusPoint {
+    byte           regType;  ///< The read command: 0x03 (holding) or 0x04 (input)
+    uint16_t       regNum;   ///< The first register of the value
+    modbusDataType type;     ///< The type of the value
+    endianness     endian;   ///< The endianness of the value
+    float    absoluteDeadband;  ///< The smallest change to report
+    float    relativeDeadband;  ///< The smallest change to report, as a fraction
+    uint32_t changeMask;  ///< The bits to watch for changes; 0 to use the deadbands
+
+    float    value;     ///< The last value reported (kept by the poller)
+    uint32_t raw;       ///< The raw bits of the last value (kept by the poller)
+    bool     reported;  ///< True once a value has been reported (kept by the poller)
+} modbusPoint;
+
+/**
+ * @brief A function that receives each value a modbusChangePoller reports
+ *
+ * @param index The index of the point in the poller's list.
+ * @param point The point, with its new value already stored.
+ * @param keyframe True if the value was reported because of a keyframe rather than a
+ * change.
+ */
+typedef void (*pointChangeCallback)(uint8_t index, const modbusPoint& point,
+                                    bool keyframe);
+
+/**
+ * @brief Polls a list of register values and reports only the ones that changed.
+ *
+ * Each call to poll() reads every point and hands the application the values that
+ * changed by more than their deadband or in their change mask.  Every so many polls
+ * (see setKeyframeInterval()), every value is reported whether it changed or not, so
+ * that a receiver that missed something can catch up.
+ *
+ * Points next to each other in the list that are of the same register type and close
+ * together (see #MODBUS_POLLER_MAX_GAP) are read in one request; list the points in
+ * address order to get the fewest requests.
+ *
+ * The points are kept in the caller's array; nothing is allocated.
+ */
+class modbusChangePoller {
+ public:
+    /**
+     * @brief Construct a new modbus Change Poller object
+     *
+     * @param master The modbusMaster to read the points with
+     * @param points The points to poll
+     * @param numPoints The number of points
+     */
+    modbusChangePoller(modbusMaster& master, modbusPoint* points, uint8_t numPoints);
+
+    /**
+     * @brief Set the function to report values to
+     *
+     * @param callback The function to call for each value reported; nullptr for none.
+     */
+    void setCallback(pointChangeCallback callback) {
+        _callback = callback;
+    }
+    /**
+     * @brief Set how often every value is reported
+     *
+     * By default, this is 0.
+     *
+     * @param polls The number of polls between keyframes; 0 for only the first poll.
+     */
+    void setKeyframeInterval(uint16_t polls) {
+        _keyframeInterval = polls;
+    }
+    /**
+     * @brief Make the next poll a keyframe
+     */
+    void forceKeyframe(void) {
+        _keyframePending = true;
+    }
+
+    /**
+     * @brief Read every point and report the values that changed
+     *
+     * Points that could not be read are not reported and keep their last value; check
+     * getFailedCount() for how many there were.
+     *
+     * @return The number of values reported.
+     */
+    uint8_t poll(void);
+
+    /**
+     * @brief Get the number of points that could not be read in the last poll
+     *
+     * @return The number of points not read.
+     */
+    uint8_t getFailedCount() const {
+        return _failedCount;
+    }
+
+ private:
+    /**
+     * @brief Check if a new value of a point should be reported
+     *
+     * @param point The point
+     * @param value The new value
+     * @param raw The raw bits of the new value
+     * @return True if the value should be reported.
+     */
+    static bool changed(const modbusPoint& point, float value, uint32_t raw);
+
+    modbusMaster&       _master;            ///< The master to read with
+    modbusPoint*        _points;            ///< The points
+    uint8_t             _numPoints;         ///< The number of points
+    pointChangeCallback _callback;          ///< The function to report to
+    uint16_t            _keyframeInterval;  ///< The number of polls between keyframes
+    uint16_t            _pollsToKeyframe;   ///< The polls left until the next keyframe
+    bool                _keyframePending;   ///< True if the next poll is a keyframe
+    uint8_t             _failedCount;       ///< The points not read in the last poll
+};
+
+#endif
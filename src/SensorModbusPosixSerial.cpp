@@ -0,0 +1,201 @@
+/**
+ * @file SensorModbusPosixSerial.cpp
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the posixSerialStream class definitions.
+ */
+
+#include "SensorModbusPosixSerial.h"
+
+#ifdef MODBUSMASTER_HAS_POSIX_SERIAL
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <linux/serial.h>
+
+posixSerialStream::posixSerialStream() : _fd(-1), _rxHead(0), _rxTail(0) {}
+
+posixSerialStream::~posixSerialStream() {
+    end();
+}
+
+
+//----------------------------------------------------------------------------
+//                           OPENING AND CLOSING
+//----------------------------------------------------------------------------
+
+bool posixSerialStream::begin(const char* device, uint32_t baudRate, char parity,
+                              uint8_t stopBits) {
+    speed_t speed;
+    switch (baudRate) {
+        case 1200: speed = B1200; break;
+        case 2400: speed = B2400; break;
+        case 4800: speed = B4800; break;
+        case 9600: speed = B9600; break;
+        case 19200: speed = B19200; break;
+        case 38400: speed = B38400; break;
+        case 57600: speed = B57600; break;
+        case 115200: speed = B115200; break;
+        case 230400: speed = B230400; break;
+        default: return false;
+    }
+
+    end();
+    int fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) { return false; }
+
+    struct termios tty;
+    if (tcgetattr(fd, &tty) != 0) {
+        close(fd);
+        return false;
+    }
+    // Raw 8-bit characters with no echo, no translation, and no flow control
+    cfmakeraw(&tty);
+    tty.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS);
+    tty.c_cflag |= CS8 | CLOCAL | CREAD;
+    if (parity == 'E' || parity == 'e') {
+        tty.c_cflag |= PARENB;
+    } else if (parity == 'O' || parity == 'o') {
+        tty.c_cflag |= PARENB | PARODD;
+    }
+    if (stopBits == 2) { tty.c_cflag |= CSTOPB; }
+    tty.c_iflag &= ~(IXON | IXOFF | IXANY);
+    // Reads never block; waiting is done with poll()
+    tty.c_cc[VMIN]  = 0;
+    tty.c_cc[VTIME] = 0;
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+        close(fd);
+        return false;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return begin(fd);
+}
+
+bool posixSerialStream::begin(int fd) {
+    if (fd < 0) { return false; }
+    if (_fd >= 0 && _fd != fd) { end(); }
+    // Make sure reads never block
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0) { fcntl(fd, F_SETFL, flags | O_NONBLOCK); }
+    _fd     = fd;
+    _rxHead = 0;
+    _rxTail = 0;
+    return true;
+}
+
+void posixSerialStream::end() {
+    if (_fd >= 0) { close(_fd); }
+    _fd     = -1;
+    _rxHead = 0;
+    _rxTail = 0;
+}
+
+bool posixSerialStream::enableRS485(bool rtsOnSend, uint32_t delayBeforeSend,
+                                    uint32_t delayAfterSend) {
+    if (_fd < 0) { return false; }
+    struct serial_rs485 rs485;
+    memset(&rs485, 0, sizeof(rs485));
+    rs485.flags = SER_RS485_ENABLED;
+    rs485.flags |= rtsOnSend ? SER_RS485_RTS_ON_SEND : SER_RS485_RTS_AFTER_SEND;
+    rs485.delay_rts_before_send = delayBeforeSend;
+    rs485.delay_rts_after_send  = delayAfterSend;
+    return ioctl(_fd, TIOCSRS485, &rs485) == 0;
+}
+
+
+//----------------------------------------------------------------------------
+//                           READING AND WAITING
+//----------------------------------------------------------------------------
+
+int posixSerialStream::fill() {
+    if (_fd < 0) { return 0; }
+    // Only read more once everything already read has been used
+    if (_rxHead == _rxTail) {
+        ssize_t got = ::read(_fd, _rxBuffer, POSIX_SERIAL_BUFFER_SIZE);
+        _rxHead     = 0;
+        _rxTail     = got > 0 ? static_cast<uint8_t>(got) : 0;
+    }
+    return _rxTail - _rxHead;
+}
+
+bool posixSerialStream::wait(uint32_t timeout) {
+    if (fill() > 0) { return true; }
+    if (_fd < 0) { return false; }
+    struct pollfd pfd;
+    pfd.fd     = _fd;
+    pfd.events = POLLIN;
+    uint32_t start = millis();
+    for (;;) {
+        uint32_t waited = millis() - start;
+        if (waited >= timeout) { return false; }
+        int ready = poll(&pfd, 1, static_cast<int>(timeout - waited));
+        if (ready > 0) { return fill() > 0; }
+        // Try again if a signal woke us up; give up on anything else
+        if (ready == 0 || errno != EINTR) { return false; }
+    }
+}
+
+int posixSerialStream::available() {
+    return fill();
+}
+
+int posixSerialStream::read() {
+    if (fill() == 0) { return -1; }
+    return _rxBuffer[_rxHead++];
+}
+
+int posixSerialStream::peek() {
+    if (fill() == 0) { return -1; }
+    return _rxBuffer[_rxHead];
+}
+
+
+//----------------------------------------------------------------------------
+//                           WRITING
+//----------------------------------------------------------------------------
+
+size_t posixSerialStream::write(uint8_t value) {
+    return write(&value, 1);
+}
+
+size_t posixSerialStream::write(const uint8_t* buffer, size_t size) {
+    if (_fd < 0) { return 0; }
+    size_t   written = 0;
+    uint32_t waited  = 0;
+    while (written < size) {
+        ssize_t sent = ::write(_fd, buffer + written, size - written);
+        if (sent > 0) {
+            written += sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) { continue; }
+        // Anything but a full kernel buffer is a failure
+        if (sent == 0 || errno != EAGAIN) { break; }
+        // Wait for room, but give up on a stalled port after the stream timeout in
+        // all, so a stuck write can't hang the master outside its own timeouts
+        if (waited >= _timeout) { break; }
+        struct pollfd pfd;
+        pfd.fd         = _fd;
+        pfd.events     = POLLOUT;
+        uint32_t start = millis();
+        int      ready = poll(&pfd, 1, static_cast<int>(_timeout - waited));
+        waited += millis() - start;
+        if (ready == 0 || (ready < 0 && errno != EINTR)) { break; }
+    }
+    return written;
+}
+
+void posixSerialStream::flush() {
+    // Block until the last byte has actually been sent
+    if (_fd >= 0) { tcdrain(_fd); }
+}
+
+#endif  // MODBUSMASTER_HAS_POSIX_SERIAL
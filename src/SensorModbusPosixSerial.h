@@ -0,0 +1,170 @@
+/**
+ * @file SensorModbusPosixSerial.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the posixSerialStream class declarations.
+ *
+ * This is a serial port backend for running the library natively on Linux (ie, on a
+ * gateway).  It is only compiled on Linux; on other platforms this file is empty.
+ */
+
+#ifndef SensorModbusPosixSerial_h
+#define SensorModbusPosixSerial_h
+
+#include "SensorModbusMaster.h"
+
+#if defined(__linux__)
+/**
+ * @brief Defined if the posixSerialStream is available on this platform
+ */
+#define MODBUSMASTER_HAS_POSIX_SERIAL
+
+/**
+ * @brief The number of received bytes buffered by a posixSerialStream between reads
+ * from the port.
+ */
+#define POSIX_SERIAL_BUFFER_SIZE 64
+
+/**
+ * @brief A Stream for a Linux serial port (or pseudo-terminal).
+ *
+ * The port is set up with termios.  Writes are finished with tcdrain(), so flush()
+ * returns only when the last bit has left the UART.  Waiting for data uses poll(), so
+ * the process sleeps instead of spinning; pass posixSerialStream::waitForData to
+ * modbusMaster::setDataWaitFunction() to use it for responses too.
+ *
+ * For RS485 adapters whose direction is controlled by the RTS line, call
+ * enableRS485() to have the kernel switch the direction exactly at the start and end
+ * of each transmission; do not give the modbusMaster an enable pin.
+ *
+ * @code{.cpp}
+ * posixSerialStream port;
+ * port.begin("/dev/ttyUSB0", 9600, 'E', 1);
+ * modbus.begin(1, port);
+ * modbus.setDataWaitFunction(posixSerialStream::waitForData);
+ * modbus.setFrameTimeout(modbusMaster::frameTimeoutForBaud(9600));
+ * @endcode
+ */
+class posixSerialStream : public Stream {
+ public:
+    /**
+     * @brief Construct a new, closed, posix Serial Stream object
+     */
+    posixSerialStream();
+    /**
+     * @brief Destroy the posix Serial Stream object, closing the port
+     */
+    virtual ~posixSerialStream();
+
+    /**
+     * @brief Open and configure a serial port
+     *
+     * The port is set to raw 8-bit mode with no flow control.
+     *
+     * @param device The path of the port, ie "/dev/ttyUSB0".
+     * @param baudRate The baud rate.  It must be one of the standard termios rates.
+     * @param parity 'N' for none, 'E' for even, or 'O' for odd. Optional with a default
+     * of 'N'.
+     * @param stopBits 1 or 2. Optional with a default of 1.
+     * @return True if the port was opened and configured.
+     */
+    bool begin(const char* device, uint32_t baudRate, char parity = 'N',
+               uint8_t stopBits = 1);
+    /**
+     * @brief Use an already open file descriptor (ie, one end of a pty pair) without
+     * changing its settings
+     *
+     * The stream takes ownership of the descriptor and closes it in end().
+     *
+     * @param fd The open file descriptor.
+     * @return True if the descriptor is valid.
+     */
+    bool begin(int fd);
+    /**
+     * @brief Close the port
+     */
+    void end();
+    /**
+     * @brief Turn on the kernel's RS485 mode, which switches the RTS line around each
+     * transmission
+     *
+     * @param rtsOnSend The level of RTS while sending; true for high. Optional with a
+     * default of true.
+     * @param delayBeforeSend The delay between switching to transmit and sending (in
+     * ms). Optional with a default of 0.
+     * @param delayAfterSend The delay between the end of sending and switching back to
+     * receive (in ms). Optional with a default of 0.
+     * @return True if the driver accepted the settings.
+     */
+    bool enableRS485(bool rtsOnSend = true, uint32_t delayBeforeSend = 0,
+                     uint32_t delayAfterSend = 0);
+    /**
+     * @brief Get the file descriptor of the port
+     *
+     * @return The file descriptor; -1 if the port is not open.
+     */
+    int getFD() const {
+        return _fd;
+    }
+
+    /**
+     * @brief Wait until data can be read, sleeping in poll()
+     *
+     * @param timeout The longest time to wait (in ms).
+     * @return True if data can be read.
+     */
+    bool wait(uint32_t timeout);
+    /**
+     * @brief A #dataWaitFunction for a modbusMaster using a posixSerialStream
+     *
+     * @param stream The stream to wait on; it must be a posixSerialStream.
+     * @param timeout The longest time to wait (in ms).
+     * @return True if data can be read.
+     */
+    static bool waitForData(Stream* stream, uint32_t timeout) {
+        return static_cast<posixSerialStream*>(stream)->wait(timeout);
+    }
+
+    // The Stream interface
+    int    available() override;
+    int    read() override;
+    int    peek() override;
+    size_t write(uint8_t value) override;
+    /**
+     * @brief Write bytes to the port, waiting for room if the kernel buffer is full
+     *
+     * The wait for room is limited to the stream timeout in all (see
+     * Stream::setTimeout(); a modbusMaster sets it to its frame timeout).
+     *
+     * @param buffer The bytes to write
+     * @param size The number of bytes
+     * @return The number of bytes written; fewer than size if the port stalled or
+     * failed.
+     */
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    /**
+     * @brief Wait until everything written has been sent (tcdrain)
+     */
+    void flush() override;
+
+ private:
+    /**
+     * @brief Move any bytes waiting in the port into the receive buffer without
+     * blocking
+     *
+     * @return The number of bytes in the receive buffer.
+     */
+    int fill();
+
+    int     _fd;  ///< The file descriptor of the port; -1 if closed
+    uint8_t _rxBuffer[POSIX_SERIAL_BUFFER_SIZE];  ///< Bytes read but not yet used
+    uint8_t _rxHead;                              ///< The next byte to hand out
+    uint8_t _rxTail;                              ///< One past the last byte read
+};
+
+#endif  // __linux__
+
+#endif
@@ -0,0 +1,288 @@
+/**
+ * @file SensorModbusRegisterMap.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the templates to describe a device's registers as a compile time
+ * map and read them all into a struct with the fewest requests.
+ *
+ * Describe each value with #MODBUS_REGISTER and list them in a modbusRegisterMap:
+ * @code{.cpp}
+ * struct sondeData {
+ *     float    temperature;
+ *     float    conductivity;
+ *     uint16_t status;
+ *     int32_t  depth;
+ * };
+ * typedef modbusRegisterMap<
+ *     MODBUS_REGISTER(sondeData, temperature, 0x1000, bigEndian, holdingRegister),
+ *     MODBUS_REGISTER(sondeData, conductivity, 0x1002, bigEndian, holdingRegister),
+ *     MODBUS_REGISTER(sondeData, status, 0x1008, bigEndian, holdingRegister),
+ *     MODBUS_REGISTER(sondeData, depth, 0x0020, littleEndian, inputRegister)>
+ *     sondeMap;
+ *
+ * sondeData data;
+ * sondeMap::readAll(modbus, data);  // two requests: 0x1000-0x1008 and 0x0020-0x0021
+ * @endcode
+ *
+ * The compiler works out which registers can be read together and where each value is
+ * within each response, so readAll() is a fixed series of getRegisterView() calls and
+ * decodes with constant arguments; no plan is built or stored at run time.
+ *
+ * Values are grouped into one request when they are in the same table, each starts at
+ * or after the first value of the request, the gap before it is at most
+ * #MODBUS_MAP_MAX_GAP registers, and the request stays within the modbus limit and the
+ * response buffer.  List the values in address order to get the fewest requests.
+ */
+
+#ifndef SensorModbusRegisterMap_h
+#define SensorModbusRegisterMap_h
+
+#include "SensorModbusMaster.h"
+
+/**
+ * @brief The most unused registers a modbusRegisterMap will read to get two values in
+ * one request
+ */
+#define MODBUS_MAP_MAX_GAP 8
+/**
+ * @brief The most registers a modbusRegisterMap will read in one request: the modbus
+ * limit of 125, or less if the response buffer is smaller
+ */
+#define MODBUS_MAP_MAX_REGISTERS \
+    ((RESPONSE_BUFFER_SIZE - 5) / 2 < 125 ? (RESPONSE_BUFFER_SIZE - 5) / 2 : 125)
+
+/**
+ * @brief Describe a struct member read from a register
+ *
+ * @param structType The struct holding the value
+ * @param member The member of the struct to put the value in; it must be a uint16_t,
+ * int16_t, uint32_t, int32_t, or float.
+ * @param address The first register of the value
+ * @param endian The #endianness of the value
+ * @param table #holdingRegister or #inputRegister
+ */
+#define MODBUS_REGISTER(structType, member, address, endian, table)             \
+    modbusRegister<decltype(structType::member), address, endian, table,        \
+                   structType, &structType::member>
+
+/**
+ * @brief How a type of value is stored in registers.
+ *
+ * Only uint16_t, int16_t, uint32_t, int32_t, and float can be stored.
+ *
+ * @tparam T The type of the value
+ */
+template <typename T>
+struct modbusTypeTraits {
+    static_assert(sizeof(T) == 0,
+                  "Registers can only hold uint16_t, int16_t, uint32_t, int32_t, or "
+                  "float values");
+};
+/// @cond
+template <>
+struct modbusTypeTraits<uint16_t> {
+    static constexpr modbusDataType type = uint16Value;
+    static uint16_t                 get(const leFrame& fram) {
+        return fram.uInt16[0];
+    }
+};
+template <>
+struct modbusTypeTraits<int16_t> {
+    static constexpr modbusDataType type = int16Value;
+    static int16_t                  get(const leFrame& fram) {
+        return fram.Int16[0];
+    }
+};
+template <>
+struct modbusTypeTraits<uint32_t> {
+    static constexpr modbusDataType type = uint32Value;
+    static uint32_t                 get(const leFrame& fram) {
+        return fram.uInt32;
+    }
+};
+template <>
+struct modbusTypeTraits<int32_t> {
+    static constexpr modbusDataType type = int32Value;
+    static int32_t                  get(const leFrame& fram) {
+        return fram.Int32;
+    }
+};
+template <>
+struct modbusTypeTraits<float> {
+    static constexpr modbusDataType type = float32Value;
+    static float                    get(const leFrame& fram) {
+        return fram.Float32;
+    }
+};
+/// @endcond
+
+/**
+ * @brief A value in one or more registers, and the struct member it is read into.
+ *
+ * Use #MODBUS_REGISTER instead of naming this directly.
+ *
+ * @tparam T The type of the value
+ * @tparam Address The first register of the value
+ * @tparam Endian The endianness of the value
+ * @tparam Table #holdingRegister or #inputRegister
+ * @tparam S The struct holding the value
+ * @tparam Member The member of the struct to put the value in
+ */
+template <typename T, uint16_t Address, endianness Endian, pointerType Table,
+          typename S, T S::*Member>
+struct modbusRegister {
+    static_assert(Table == holdingRegister || Table == inputRegister,
+                  "A register map can only read holding or input registers");
+
+    /// The first register of the value
+    static constexpr uint16_t address = Address;
+    /// The number of registers the value takes
+    static constexpr uint16_t registers =
+        modbusFrameView::registersFor(modbusTypeTraits<T>::type);
+    /// The command to read the value with
+    static constexpr byte readCommand = Table == holdingRegister ? 0x03 : 0x04;
+
+    /**
+     * @brief Decode the value from a view and put it in the struct
+     *
+     * @param view The registers read
+     * @param first The first register in the view
+     * @param out The struct to put the value in
+     */
+    static void decode(const modbusFrameView& view, uint16_t first, S& out) {
+        leFrame fram;
+        fram.uInt32 = view.rawAt(Address - first, modbusTypeTraits<T>::type, Endian);
+        out.*Member = modbusTypeTraits<T>::get(fram);
+    }
+};
+
+/// @cond
+// Works out how many of the registers after the first in a request can join it and
+// where the request ends
+template <byte Command, uint16_t Start, uint16_t End, typename... Regs>
+struct modbusMapExtent {
+    static constexpr uint8_t  count = 0;
+    static constexpr uint16_t end   = End;
+};
+template <byte Command, uint16_t Start, uint16_t End, typename Next, typename... Rest>
+struct modbusMapExtent<Command, Start, End, Next, Rest...> {
+    static constexpr uint16_t nextEnd = Next::address + Next::registers > End
+        ? Next::address + Next::registers
+        : End;
+    static constexpr bool joins = Next::readCommand == Command &&
+        Next::address >= Start && Next::address <= End + MODBUS_MAP_MAX_GAP &&
+        nextEnd - Start <= MODBUS_MAP_MAX_REGISTERS;
+    typedef modbusMapExtent<Command, Start, nextEnd, Rest...> further;
+    static constexpr uint8_t  count = joins ? 1 + further::count : 0;
+    static constexpr uint16_t end   = joins ? further::end : End;
+};
+
+// Decodes the first N registers from one response
+template <uint8_t N, uint16_t First, typename... Regs>
+struct modbusMapDecoder {
+    template <typename S>
+    static void decode(const modbusFrameView&, S&) {}
+};
+template <uint8_t N, uint16_t First, typename Reg, typename... Rest>
+struct modbusMapDecoder<N, First, Reg, Rest...> {
+    template <typename S>
+    static void decode(const modbusFrameView& view, S& out) {
+        Reg::decode(view, First, out);
+        modbusMapDecoder<N - 1, First, Rest...>::decode(view, out);
+    }
+};
+template <uint16_t First, typename Reg, typename... Rest>
+struct modbusMapDecoder<0, First, Reg, Rest...> {
+    template <typename S>
+    static void decode(const modbusFrameView&, S&) {}
+};
+
+template <typename... Regs>
+struct modbusMapReader;
+
+// Skips the first N registers
+template <uint8_t N, typename... Regs>
+struct modbusMapSkip {
+    typedef modbusMapReader<Regs...> reader;
+};
+template <uint8_t N, typename Reg, typename... Rest>
+struct modbusMapSkip<N, Reg, Rest...> {
+    typedef typename modbusMapSkip<N - 1, Rest...>::reader reader;
+};
+template <typename Reg, typename... Rest>
+struct modbusMapSkip<0, Reg, Rest...> {
+    typedef modbusMapReader<Reg, Rest...> reader;
+};
+
+// Reads the request starting with the first register, then the rest
+template <typename... Regs>
+struct modbusMapReader {
+    static constexpr uint8_t requests = 0;
+    template <typename S>
+    static bool read(modbusMaster&, S&) {
+        return true;
+    }
+};
+template <typename Reg, typename... Rest>
+struct modbusMapReader<Reg, Rest...> {
+    typedef modbusMapExtent<Reg::readCommand, Reg::address,
+                            Reg::address + Reg::registers, Rest...>
+                                                     extent;
+    typedef typename modbusMapSkip<extent::count, Rest...>::reader next;
+    static constexpr uint8_t requests = 1 + next::requests;
+
+    template <typename S>
+    static bool read(modbusMaster& master, S& out) {
+        modbusFrameView view = master.getRegisterView(
+            Reg::readCommand, Reg::address, extent::end - Reg::address);
+        bool success = view.valid();
+        if (success) {
+            modbusMapDecoder<extent::count + 1, Reg::address, Reg, Rest...>::decode(
+                view, out);
+        }
+        // Keep going after a failure so the other requests still fill their values
+        return next::read(master, out) && success;
+    }
+};
+/// @endcond
+
+/**
+ * @brief A compile time map of the registers of a device.
+ *
+ * @tparam Regs The values in the map, each described with #MODBUS_REGISTER
+ */
+template <typename... Regs>
+struct modbusRegisterMap {
+    /// The number of requests readAll() sends
+    static constexpr uint8_t requests = modbusMapReader<Regs...>::requests;
+
+    /**
+     * @brief Read every value in the map into a struct
+     *
+     * If a request fails, the values it holds are left unchanged and the rest are
+     * still read; check getLastError() for the reason.
+     *
+     * @tparam S The struct holding the values
+     * @param master The modbusMaster to read with
+     * @param out The struct to put the values in
+     * @return True if every request succeeded.
+     */
+    template <typename S>
+    static bool readAll(modbusMaster& master, S& out) {
+        return modbusMapReader<Regs...>::read(master, out);
+    }
+};
+
+/**
+ * @brief Read every value in a register map into a struct
+ *
+ * @copydetails modbusRegisterMap::readAll(modbusMaster&, S&)
+ */
+template <typename... Regs, typename S>
+bool readAll(modbusMaster& master, modbusRegisterMap<Regs...>, S& out) {
+    return modbusRegisterMap<Regs...>::readAll(master, out);
+}
+
+#endif
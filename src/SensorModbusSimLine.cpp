@@ -0,0 +1,105 @@
+/**
+ * @file SensorModbusSimLine.cpp
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusSimLine class definitions.
+ */
+
+#include "SensorModbusSimLine.h"
+
+#ifdef MODBUSMASTER_VIRTUAL_CLOCK
+
+modbusSimLine::modbusSimLine(uint32_t baudRate)
+    : _charTime(modbusMaster::charTimeMicros(baudRate)),
+      _byteCount(0) {
+    clear();
+    for (uint8_t i = 0; i < 2; i++) {
+        _ends[i]._line = this;
+        _ends[i]._side = i;
+    }
+    modbusVirtualClock::addTask(clockTask, this);
+}
+
+modbusSimLine::~modbusSimLine() {
+    modbusVirtualClock::removeTask(clockTask, this);
+}
+
+void modbusSimLine::clear(void) {
+    for (uint8_t i = 0; i < 2; i++) {
+        _channels[i].head      = 0;
+        _channels[i].count     = 0;
+        _channels[i].busyUntil = 0;
+    }
+}
+
+uint16_t modbusSimLine::arrived(const simChannel& channel) {
+    uint64_t now = modbusVirtualClock::now();
+    uint16_t n   = 0;
+    while (n < channel.count &&
+           channel.arrival[(channel.head + n) % MODBUS_SIM_LINE_BUFFER_SIZE] <= now) {
+        n++;
+    }
+    return n;
+}
+
+uint64_t modbusSimLine::clockTask(void* context) {
+    modbusSimLine* line = static_cast<modbusSimLine*>(context);
+    uint64_t       next = UINT64_MAX;
+    for (uint8_t i = 0; i < 2; i++) {
+        const simChannel& channel = line->_channels[i];
+        uint16_t          n       = arrived(channel);
+        if (n < channel.count) {
+            uint64_t event =
+                channel.arrival[(channel.head + n) % MODBUS_SIM_LINE_BUFFER_SIZE];
+            if (event < next) { next = event; }
+        }
+    }
+    return next;
+}
+
+
+int modbusSimEnd::available() {
+    return modbusSimLine::arrived(_line->_channels[_side]);
+}
+
+int modbusSimEnd::read() {
+    modbusSimLine::simChannel& channel = _line->_channels[_side];
+    if (modbusSimLine::arrived(channel) == 0) { return -1; }
+    byte value   = channel.data[channel.head];
+    channel.head = (channel.head + 1) % MODBUS_SIM_LINE_BUFFER_SIZE;
+    channel.count--;
+    return value;
+}
+
+int modbusSimEnd::peek() {
+    const modbusSimLine::simChannel& channel = _line->_channels[_side];
+    if (modbusSimLine::arrived(channel) == 0) { return -1; }
+    return channel.data[channel.head];
+}
+
+size_t modbusSimEnd::write(uint8_t value) {
+    // Write into the channel read by the other end
+    modbusSimLine::simChannel& channel = _line->_channels[_side ^ 1];
+    if (channel.count >= MODBUS_SIM_LINE_BUFFER_SIZE) { return 0; }
+    // The byte starts when the line is free and arrives one character later
+    uint64_t start = modbusVirtualClock::now();
+    if (channel.busyUntil > start) { start = channel.busyUntil; }
+    channel.busyUntil = start + _line->_charTime;
+    uint16_t index =
+        (channel.head + channel.count) % MODBUS_SIM_LINE_BUFFER_SIZE;
+    channel.data[index]    = value;
+    channel.arrival[index] = channel.busyUntil;
+    channel.count++;
+    _line->_byteCount++;
+    return 1;
+}
+
+void modbusSimEnd::flush() {
+    uint64_t busyUntil = _line->_channels[_side ^ 1].busyUntil;
+    uint64_t now       = modbusVirtualClock::now();
+    if (busyUntil > now) { modbusVirtualClock::advance(busyUntil - now); }
+}
+
+#endif  // MODBUSMASTER_VIRTUAL_CLOCK
@@ -0,0 +1,159 @@
+/**
+ * @file SensorModbusSimLine.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusSimLine class declarations.
+ *
+ * The simulated line needs the virtual clock; without MODBUSMASTER_VIRTUAL_CLOCK in the
+ * build flags this file is empty.
+ */
+
+#ifndef SensorModbusSimLine_h
+#define SensorModbusSimLine_h
+
+#include "SensorModbusMaster.h"
+
+#ifdef MODBUSMASTER_VIRTUAL_CLOCK
+
+/**
+ * @brief The most bytes that can be on their way in each direction of a simulated line
+ *
+ * Bytes written while the line is full are lost.
+ */
+#define MODBUS_SIM_LINE_BUFFER_SIZE 512
+
+class modbusSimLine;
+
+/**
+ * @brief One end of a modbusSimLine; use it as the stream of a modbusMaster or
+ * modbusSlave.
+ */
+class modbusSimEnd : public Stream {
+ public:
+    int    available() override;
+    int    read() override;
+    int    peek() override;
+    size_t write(uint8_t value) override;
+    using Print::write;
+    /**
+     * @brief Wait on the virtual clock until everything written to this end has been
+     * sent
+     */
+    void flush() override;
+
+ private:
+    friend class modbusSimLine;
+    modbusSimLine* _line;  ///< The line this is an end of
+    uint8_t        _side;  ///< The direction this end reads from (0 or 1)
+};
+
+/**
+ * @brief A simulated serial line between two streams, timed by the virtual clock.
+ *
+ * A byte written to one end arrives at the other end one character time (11 bits at
+ * the line's baud rate) after the previous byte finished or after it was written,
+ * whichever is later.  Until then, the other end cannot see it.  Nothing ever happens
+ * in real time, so a program can use modbusMaster and modbusSlave on the two ends and
+ * get exactly the same timing on every run.
+ *
+ * The slave on the far end still needs its task() run while the master waits; add it
+ * to the virtual clock as a task:
+ * @code{.cpp}
+ * modbusVirtualClock::addTask(
+ *     [](void* slave) -> uint64_t {
+ *         static_cast<modbusSlave*>(slave)->task();
+ *         return UINT64_MAX;
+ *     },
+ *     &slave);
+ * @endcode
+ */
+class modbusSimLine {
+ public:
+    /**
+     * @brief Construct a new simulated line and add it to the virtual clock
+     *
+     * @param baudRate The baud rate of the line. Optional with a default of 9600.
+     */
+    explicit modbusSimLine(uint32_t baudRate = 9600);
+    /**
+     * @brief Destroy the simulated line and remove it from the virtual clock
+     */
+    ~modbusSimLine();
+
+    /**
+     * @brief Get the first end of the line
+     *
+     * @return The stream at the first end.
+     */
+    modbusSimEnd& endA() {
+        return _ends[0];
+    }
+    /**
+     * @brief Get the second end of the line
+     *
+     * @return The stream at the second end.
+     */
+    modbusSimEnd& endB() {
+        return _ends[1];
+    }
+
+    /**
+     * @brief Set the baud rate of the line
+     *
+     * @param baudRate The baud rate
+     */
+    void setBaudRate(uint32_t baudRate) {
+        _charTime = modbusMaster::charTimeMicros(baudRate);
+    }
+    /**
+     * @brief Drop everything on its way in both directions
+     */
+    void clear(void);
+    /**
+     * @brief Get the number of bytes sent over the line in both directions
+     *
+     * @return The number of bytes sent.
+     */
+    uint32_t getByteCount() const {
+        return _byteCount;
+    }
+
+ private:
+    friend class modbusSimEnd;
+    /**
+     * @brief The bytes on their way in one direction
+     */
+    typedef struct simChannel {
+        uint16_t head;       ///< The index of the oldest byte
+        uint16_t count;      ///< The number of bytes on their way
+        uint64_t busyUntil;  ///< When the last byte written finishes sending
+        byte     data[MODBUS_SIM_LINE_BUFFER_SIZE];      ///< The bytes
+        uint64_t arrival[MODBUS_SIM_LINE_BUFFER_SIZE];  ///< When each byte arrives
+    } simChannel;
+
+    /**
+     * @brief Get the number of bytes that have arrived on a channel
+     *
+     * @param channel The channel
+     * @return The number of bytes that can be read.
+     */
+    static uint16_t arrived(const simChannel& channel);
+    /**
+     * @brief The virtual clock task of the line
+     *
+     * @param context The line
+     * @return The arrival time of the next byte on its way.
+     */
+    static uint64_t clockTask(void* context);
+
+    uint32_t     _charTime;   ///< The time to send one character (µs)
+    uint32_t     _byteCount;  ///< The number of bytes sent
+    simChannel   _channels[2];  ///< The bytes going to each end
+    modbusSimEnd _ends[2];      ///< The two ends
+};
+
+#endif  // MODBUSMASTER_VIRTUAL_CLOCK
+
+#endif
@@ -0,0 +1,298 @@
+/**
+ * @file SensorModbusSlave.cpp
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusSlave class definitions.
+ */
+
+#include "SensorModbusSlave.h"
+
+modbusSlave::modbusSlave()
+    : _slaveID(1),
+      _stream(nullptr),
+      _enablePin(-1),
+      _coils(nullptr),
+      _coilStart(0),
+      _coilCount(0),
+      _inputs(nullptr),
+      _inputStart(0),
+      _inputCount(0),
+      _holding(nullptr),
+      _holdingStart(0),
+      _holdingCount(0),
+      _inputRegisters(nullptr),
+      _inputRegisterStart(0),
+      _inputRegisterCount(0),
+      _frameTimeout(MODBUS_FRAME_TIMEOUT),
+      _turnaroundDelay(0),
+      _requestHook(nullptr),
+      _fault(faultNone),
+      _faultCount(0),
+      _faultException(SLAVE_DEVICE_BUSY),
+      _requestCount(0),
+      _frameLength(0),
+      _lastByteTime(0),
+      _responseLength(0),
+      _responseTime(0) {}
+
+
+//----------------------------------------------------------------------------
+//                           BEGINS AND SETTERS
+//----------------------------------------------------------------------------
+
+bool modbusSlave::begin(byte slaveID, Stream* stream, int8_t enablePin) {
+    _slaveID   = slaveID;
+    _stream    = stream;
+    _enablePin = enablePin;
+    if (_enablePin >= 0) {
+        pinMode(_enablePin, OUTPUT);
+        digitalWrite(_enablePin, LOW);
+    }
+    _frameLength    = 0;
+    _responseLength = 0;
+    return true;
+}
+bool modbusSlave::begin(byte slaveID, Stream& stream, int8_t enablePin) {
+    return begin(slaveID, &stream, enablePin);
+}
+
+void modbusSlave::setCoilTable(byte* coils, uint16_t start, uint16_t count) {
+    _coils     = coils;
+    _coilStart = start;
+    _coilCount = coils == nullptr ? 0 : count;
+}
+void modbusSlave::setDiscreteInputTable(byte* inputs, uint16_t start, uint16_t count) {
+    _inputs     = inputs;
+    _inputStart = start;
+    _inputCount = inputs == nullptr ? 0 : count;
+}
+void modbusSlave::setHoldingRegisterTable(uint16_t* registers, uint16_t start,
+                                          uint16_t count) {
+    _holding      = registers;
+    _holdingStart = start;
+    _holdingCount = registers == nullptr ? 0 : count;
+}
+void modbusSlave::setInputRegisterTable(uint16_t* registers, uint16_t start,
+                                        uint16_t count) {
+    _inputRegisters     = registers;
+    _inputRegisterStart = start;
+    _inputRegisterCount = registers == nullptr ? 0 : count;
+}
+
+void modbusSlave::injectFault(modbusFault fault, uint16_t count,
+                              modbusErrorCode exception) {
+    _fault          = fault;
+    _faultCount     = fault == faultNone ? 0 : count;
+    _faultException = exception;
+}
+
+
+//----------------------------------------------------------------------------
+//                           THE MAIN LOOP
+//----------------------------------------------------------------------------
+
+bool modbusSlave::task(void) {
+    if (_stream == nullptr) { return false; }
+
+    // Answer once the turnaround delay has passed
+    if (_responseLength > 0) {
+        if (MODBUS_MILLIS() - _responseTime < _turnaroundDelay) { return false; }
+        sendResponse();
+        return true;
+    }
+
+    // Take in whatever has arrived
+    while (_stream->available() > 0) {
+        int value = _stream->read();
+        // Anything past the end of the buffer can't be a valid frame; the CRC check
+        // will throw it out
+        if (_frameLength < MODBUS_SLAVE_BUFFER_SIZE) {
+            _frame[_frameLength++] = static_cast<byte>(value);
+        }
+        _lastByteTime = MODBUS_MILLIS();
+    }
+
+    // The request is complete once the line goes quiet
+    if (_frameLength == 0 || MODBUS_MILLIS() - _lastByteTime < _frameTimeout) {
+        return false;
+    }
+    uint16_t length = _frameLength;
+    _frameLength    = 0;
+
+    // Ignore anything that isn't a good frame for this slave or a broadcast
+    if (length < 4 || (_frame[0] != _slaveID && _frame[0] != 0)) { return false; }
+    uint16_t crc = modbusMaster::crc16(_frame, length - 2);
+    if ((crc & 0xFF) != _frame[length - 2] || (crc >> 8) != _frame[length - 1]) {
+        return false;
+    }
+    _requestCount++;
+
+    // Take any injected fault before serving the request, so that a request that
+    // fails leaves the tables alone, as it would on a real busy device
+    modbusFault fault = faultNone;
+    if (_frame[0] != 0 && _faultCount > 0) {
+        fault = _fault;
+        _faultCount--;
+    }
+    if (fault == faultSilence) { return false; }
+
+    uint16_t responseLength = fault == faultException ? exception(_faultException)
+                                                      : serve(length - 2);
+    // Broadcasts are never answered
+    if (_frame[0] == 0) { return false; }
+
+    // Add the CRC
+    crc                        = modbusMaster::crc16(_frame, responseLength);
+    _frame[responseLength]     = crc & 0xFF;
+    _frame[responseLength + 1] = crc >> 8;
+    if (fault == faultBadCRC) { _frame[responseLength + 1] ^= 0xFF; }
+    _responseLength = responseLength + 2;
+    _responseTime   = MODBUS_MILLIS();
+
+    if (_turnaroundDelay > 0) { return false; }
+    sendResponse();
+    return true;
+}
+
+void modbusSlave::sendResponse(void) {
+    if (_enablePin >= 0) { digitalWrite(_enablePin, HIGH); }
+    _stream->write(_frame, _responseLength);
+    _stream->flush();
+    if (_enablePin >= 0) { digitalWrite(_enablePin, LOW); }
+    _responseLength = 0;
+}
+
+
+//----------------------------------------------------------------------------
+//                           SERVING REQUESTS
+//----------------------------------------------------------------------------
+
+uint16_t modbusSlave::serve(uint16_t length) {
+    byte fxn = _frame[1];
+    // Every supported request has at least an address and a quantity or value
+    if (length < 6) {
+        return exception(fxn <= 0x06 || fxn == 0x0F || fxn == 0x10 ? ILLEGAL_DATA_VALUE
+                                                                   : ILLEGAL_FUNCTION);
+    }
+    uint16_t address = (_frame[2] << 8) | _frame[3];
+    uint16_t count   = (_frame[4] << 8) | _frame[5];
+    uint16_t value   = count;
+    if (fxn == 0x05 || fxn == 0x06) { count = 1; }
+
+    if (_requestHook != nullptr) {
+        modbusErrorCode error = _requestHook(fxn, address, count);
+        if (error != NO_ERROR) { return exception(error); }
+    }
+
+    // Pick the table and the quantity limit for the function
+    byte*     bits     = nullptr;
+    uint16_t* regs     = nullptr;
+    uint16_t  start    = 0;
+    uint16_t  size     = 0;
+    uint16_t  maxCount = 1;
+    switch (fxn) {
+        case 0x01:  // Read Coils
+        case 0x05:  // Write Single Coil
+        case 0x0F:  // Write Multiple Coils
+            bits     = _coils;
+            start    = _coilStart;
+            size     = _coilCount;
+            maxCount = fxn == 0x01 ? 2000 : fxn == 0x0F ? 1968 : 1;
+            break;
+        case 0x02:  // Read Discrete Inputs
+            bits     = _inputs;
+            start    = _inputStart;
+            size     = _inputCount;
+            maxCount = 2000;
+            break;
+        case 0x03:  // Read Holding Registers
+        case 0x06:  // Write Single Register
+        case 0x10:  // Write Multiple Registers
+            regs     = _holding;
+            start    = _holdingStart;
+            size     = _holdingCount;
+            maxCount = fxn == 0x03 ? 125 : fxn == 0x10 ? 123 : 1;
+            break;
+        case 0x04:  // Read Input Registers
+            regs     = _inputRegisters;
+            start    = _inputRegisterStart;
+            size     = _inputRegisterCount;
+            maxCount = 125;
+            break;
+        default: return exception(ILLEGAL_FUNCTION);
+    }
+    if (count < 1 || count > maxCount) { return exception(ILLEGAL_DATA_VALUE); }
+    if (address < start ||
+        static_cast<uint32_t>(address) + count > static_cast<uint32_t>(start) + size) {
+        return exception(ILLEGAL_DATA_ADDRESS);
+    }
+    uint16_t offset = address - start;
+
+    switch (fxn) {
+        case 0x01:
+        case 0x02: {
+            // {slaveID, fxnCode, # bytes, packed bits}
+            uint8_t numBytes = (count + 7) / 8;
+            _frame[2]        = numBytes;
+            memset(_frame + 3, 0, numBytes);
+            for (uint16_t i = 0; i < count; i++) {
+                if (getBit(bits, offset + i)) { setBit(_frame + 3, i, true); }
+            }
+            return 3 + numBytes;
+        }
+        case 0x03:
+        case 0x04: {
+            // {slaveID, fxnCode, # bytes, registers (hi/lo)}
+            _frame[2] = count * 2;
+            for (uint16_t i = 0; i < count; i++) {
+                _frame[3 + i * 2] = regs[offset + i] >> 8;
+                _frame[4 + i * 2] = regs[offset + i] & 0xFF;
+            }
+            return 3 + count * 2;
+        }
+        case 0x05:
+            if (value != 0xFF00 && value != 0x0000) {
+                return exception(ILLEGAL_DATA_VALUE);
+            }
+            setBit(bits, offset, value == 0xFF00);
+            // The response echoes the request
+            return 6;
+        case 0x06:
+            regs[offset] = value;
+            // The response echoes the request
+            return 6;
+        case 0x0F: {
+            // {slaveID, fxnCode, address (hi/lo), # coils (hi/lo), # bytes, bits}
+            uint8_t numBytes = (count + 7) / 8;
+            if (length < 7 || _frame[6] != numBytes || length != 7 + numBytes) {
+                return exception(ILLEGAL_DATA_VALUE);
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                setBit(bits, offset + i, getBit(_frame + 7, i));
+            }
+            // The response is the address and number of coils
+            return 6;
+        }
+        case 0x10:
+        default: {
+            // {slaveID, fxnCode, address (hi/lo), # regs (hi/lo), # bytes, registers}
+            if (length < 7 || _frame[6] != count * 2 || length != 7 + count * 2) {
+                return exception(ILLEGAL_DATA_VALUE);
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                regs[offset + i] = (_frame[7 + i * 2] << 8) | _frame[8 + i * 2];
+            }
+            // The response is the address and number of registers
+            return 6;
+        }
+    }
+}
+
+uint16_t modbusSlave::exception(modbusErrorCode error) {
+    // {slaveID, fxnCode | 0x80, exception code}
+    _frame[1] |= 0x80;
+    _frame[2] = static_cast<byte>(error);
+    return 3;
+}
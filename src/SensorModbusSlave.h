@@ -0,0 +1,252 @@
+/**
+ * @file SensorModbusSlave.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusSlave class declarations.
+ */
+
+#ifndef SensorModbusSlave_h
+#define SensorModbusSlave_h
+
+#include "SensorModbusMaster.h"
+
+/**
+ * @brief The size of the frame buffer of a modbus slave.
+ *
+ * The same buffer holds the request and then the response, so it must fit the
+ * largest of either; modbus RTU frames are at most 256 bytes.
+ */
+#define MODBUS_SLAVE_BUFFER_SIZE 256
+
+/**
+ * @brief The faults a modbusSlave can be told to inject into its responses.
+ */
+typedef enum modbusFault {
+    faultNone = 0,   ///< Answer normally
+    faultBadCRC,     ///< Answer with a corrupted CRC
+    faultException,  ///< Answer with an exception without serving the request
+    faultSilence     ///< Do not answer or serve the request at all
+} modbusFault;
+
+/**
+ * @brief A function called for every request addressed to a modbusSlave, before it
+ * is served.
+ *
+ * @param function The function code of the request.
+ * @param address The first coil, input, or register of the request.
+ * @param count The number of coils, inputs, or registers in the request.
+ * @return #NO_ERROR to serve the request normally, or the exception to answer with.
+ */
+typedef modbusErrorCode (*slaveRequestHook)(byte function, uint16_t address,
+                                            uint16_t count);
+
+/**
+ * @brief A modbus RTU slave serving data from tables in memory.
+ *
+ * The slave can be used as firmware for a smart sensor or as a stand-in for a real
+ * device while testing a modbusMaster.  It serves:
+ * - 0x01 read coils and 0x05/0x0F write coils
+ * - 0x02 read discrete inputs
+ * - 0x03 read holding registers and 0x06/0x10 write holding registers
+ * - 0x04 read input registers
+ *
+ * Coils and discrete inputs are packed 8 to a byte, least significant bit first, as
+ * in a modbus frame.  Registers are stored as native uint16_t values.  Each table
+ * starts at a modbus address and covers a number of coils, inputs, or registers; any
+ * request outside of a table gets an #ILLEGAL_DATA_ADDRESS exception.
+ *
+ * The slave never blocks: call task() as often as possible from your loop.
+ */
+class modbusSlave {
+ public:
+    /**
+     * @brief Construct a new modbus Slave object
+     */
+    modbusSlave();
+
+    /**
+     * @brief Start the slave
+     *
+     * @param slaveID The modbus slave ID to answer to.
+     * @param stream A pointer to the Arduino stream object to communicate with.
+     * @param enablePin A pin on the Arduino processor to use to send data to an RS485
+     * adapter. Optional with a default value of -1 (no enable pin).
+     * @return Always returns true
+     */
+    bool begin(byte slaveID, Stream* stream, int8_t enablePin = -1);
+    /**
+     * @copydoc modbusSlave::begin(byte, Stream*, int8_t)
+     */
+    bool begin(byte slaveID, Stream& stream, int8_t enablePin = -1);
+
+    /**
+     * @brief Set the table of output coils
+     *
+     * @param coils The packed coil states; nullptr for no coils.
+     * @param start The modbus address of the first coil.
+     * @param count The number of coils.
+     */
+    void setCoilTable(byte* coils, uint16_t start, uint16_t count);
+    /**
+     * @brief Set the table of discrete inputs
+     *
+     * @param inputs The packed input states; nullptr for no inputs.
+     * @param start The modbus address of the first input.
+     * @param count The number of inputs.
+     */
+    void setDiscreteInputTable(byte* inputs, uint16_t start, uint16_t count);
+    /**
+     * @brief Set the table of holding registers
+     *
+     * @param registers The register values; nullptr for no holding registers.
+     * @param start The modbus address of the first register.
+     * @param count The number of registers.
+     */
+    void setHoldingRegisterTable(uint16_t* registers, uint16_t start, uint16_t count);
+    /**
+     * @brief Set the table of input registers
+     *
+     * @param registers The register values; nullptr for no input registers.
+     * @param start The modbus address of the first register.
+     * @param count The number of registers.
+     */
+    void setInputRegisterTable(uint16_t* registers, uint16_t start, uint16_t count);
+
+    /**
+     * @brief Set the silence that ends a request frame (in ms)
+     *
+     * By default, this is #MODBUS_FRAME_TIMEOUT.
+     *
+     * @param timeout The frame timeout in milliseconds.
+     */
+    void setFrameTimeout(uint32_t timeout) {
+        _frameTimeout = timeout;
+    }
+    /**
+     * @brief Set the time to wait after a request before answering (in ms)
+     *
+     * By default, this is 0.
+     *
+     * @param delay The turnaround delay in milliseconds.
+     */
+    void setTurnaroundDelay(uint32_t delay) {
+        _turnaroundDelay = delay;
+    }
+    /**
+     * @brief Set the function to call for each request before it is served
+     *
+     * @param hook The function to call; nullptr for none.
+     */
+    void setRequestHook(slaveRequestHook hook) {
+        _requestHook = hook;
+    }
+    /**
+     * @brief Inject a fault into the next requests addressed to this slave
+     *
+     * @param fault The fault to inject.
+     * @param count The number of requests to inject the fault into. Optional with a
+     * default of 1.
+     * @param exception The exception to answer with for #faultException. Optional
+     * with a default of #SLAVE_DEVICE_BUSY.
+     */
+    void injectFault(modbusFault fault, uint16_t count = 1,
+                     modbusErrorCode exception = SLAVE_DEVICE_BUSY);
+
+    /**
+     * @brief Receive, serve, and answer requests without blocking
+     *
+     * Call this as often as possible.
+     *
+     * @return True if a response was sent during this call.
+     */
+    bool task(void);
+
+    /**
+     * @brief Get the number of requests addressed to this slave (or broadcast) that
+     * have been received
+     *
+     * @return The number of requests received.
+     */
+    uint32_t getRequestCount() const {
+        return _requestCount;
+    }
+
+ private:
+    /**
+     * @brief Serve the request in the frame buffer and build the response in its place
+     *
+     * @param length The length of the request without the CRC
+     * @return The length of the response without the CRC.
+     */
+    uint16_t serve(uint16_t length);
+    /**
+     * @brief Send the response waiting in the frame buffer
+     */
+    void sendResponse(void);
+    /**
+     * @brief Build an exception response in the frame buffer
+     *
+     * @param error The exception code
+     * @return The length of the response without the CRC
+     */
+    uint16_t exception(modbusErrorCode error);
+    /**
+     * @brief Read a bit out of a packed table
+     *
+     * @param table The packed table
+     * @param index The index of the bit
+     * @return The bit
+     */
+    static bool getBit(const byte* table, uint16_t index) {
+        return (table[index / 8] >> (index % 8)) & 0x01;
+    }
+    /**
+     * @brief Write a bit into a packed table
+     *
+     * @param table The packed table
+     * @param index The index of the bit
+     * @param value The bit
+     */
+    static void setBit(byte* table, uint16_t index, bool value) {
+        if (value) {
+            table[index / 8] |= static_cast<byte>(1 << (index % 8));
+        } else {
+            table[index / 8] &= static_cast<byte>(~(1 << (index % 8)));
+        }
+    }
+
+    byte    _slaveID;     ///< The slave ID to answer to
+    Stream* _stream;      ///< The stream to communicate over
+    int8_t  _enablePin;   ///< The RS485 direction pin; -1 if none
+
+    byte*     _coils;              ///< The packed coil states
+    uint16_t  _coilStart;          ///< The address of the first coil
+    uint16_t  _coilCount;          ///< The number of coils
+    byte*     _inputs;             ///< The packed discrete input states
+    uint16_t  _inputStart;         ///< The address of the first discrete input
+    uint16_t  _inputCount;         ///< The number of discrete inputs
+    uint16_t* _holding;            ///< The holding register values
+    uint16_t  _holdingStart;       ///< The address of the first holding register
+    uint16_t  _holdingCount;       ///< The number of holding registers
+    uint16_t* _inputRegisters;     ///< The input register values
+    uint16_t  _inputRegisterStart; ///< The address of the first input register
+    uint16_t  _inputRegisterCount; ///< The number of input registers
+
+    uint32_t         _frameTimeout;     ///< The silence that ends a frame (in ms)
+    uint32_t         _turnaroundDelay;  ///< The wait before answering (in ms)
+    slaveRequestHook _requestHook;      ///< Called before serving each request
+    modbusFault      _fault;            ///< The fault to inject
+    uint16_t         _faultCount;       ///< The number of requests left to fault
+    modbusErrorCode  _faultException;   ///< The exception for #faultException
+    uint32_t         _requestCount;     ///< The number of requests received
+
+    uint16_t _frameLength;   ///< The number of bytes in the frame buffer
+    uint32_t _lastByteTime;  ///< When the last byte of the request arrived
+    uint16_t _responseLength;  ///< The length of the response waiting to be sent
+    uint32_t _responseTime;    ///< When the request being answered was complete
+    byte     _frame[MODBUS_SLAVE_BUFFER_SIZE];  ///< The request, then the response
+};
+
+#endif
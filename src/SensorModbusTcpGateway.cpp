@@ -0,0 +1,342 @@
+/**
+ * @file SensorModbusTcpGateway.cpp
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusTcpGateway class definitions.
+ */
+
+#include "SensorModbusTcpGateway.h"
+
+#ifdef MODBUSMASTER_HAS_TCP_GATEWAY
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+modbusTcpGateway::modbusTcpGateway(modbusMaster& master)
+    : _master(master),
+      _listenFD(-1),
+      _nextSequence(0),
+      _lastUnit(0),
+      _requestCount(0),
+      _forwardCount(0),
+      _coalescedCount(0) {
+    for (uint8_t i = 0; i < MODBUS_GATEWAY_MAX_CLIENTS; i++) {
+        _clients[i].fd       = -1;
+        _clients[i].rxLength = 0;
+    }
+    for (uint8_t i = 0; i < MODBUS_GATEWAY_QUEUE_SIZE; i++) { _queue[i].inUse = false; }
+}
+
+modbusTcpGateway::~modbusTcpGateway() {
+    end();
+}
+
+
+//----------------------------------------------------------------------------
+//                           STARTING AND STOPPING
+//----------------------------------------------------------------------------
+
+bool modbusTcpGateway::begin(uint16_t port, const char* bindAddress) {
+    end();
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) { return false; }
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bindAddress != nullptr &&
+        inet_pton(AF_INET, bindAddress, &addr.sin_addr) != 1) {
+        close(fd);
+        return false;
+    }
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(fd, MODBUS_GATEWAY_MAX_CLIENTS) != 0) {
+        close(fd);
+        return false;
+    }
+    _listenFD = fd;
+    return true;
+}
+
+void modbusTcpGateway::end() {
+    for (uint8_t i = 0; i < MODBUS_GATEWAY_MAX_CLIENTS; i++) { closeClient(i); }
+    if (_listenFD >= 0) { close(_listenFD); }
+    _listenFD = -1;
+}
+
+uint16_t modbusTcpGateway::getPort() const {
+    if (_listenFD < 0) { return 0; }
+    struct sockaddr_in addr;
+    socklen_t          length = sizeof(addr);
+    if (getsockname(_listenFD, reinterpret_cast<struct sockaddr*>(&addr), &length) !=
+        0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+
+//----------------------------------------------------------------------------
+//                           THE MAIN LOOP
+//----------------------------------------------------------------------------
+
+uint16_t modbusTcpGateway::process(uint32_t timeout) {
+    if (_listenFD < 0) { return 0; }
+
+    // Don't sleep if there are requests waiting for the bus
+    uint8_t waiting = 0;
+    for (uint8_t i = 0; i < MODBUS_GATEWAY_QUEUE_SIZE; i++) {
+        if (_queue[i].inUse) { waiting++; }
+    }
+
+    // Wait for a new client or for data from a connected one
+    struct pollfd fds[MODBUS_GATEWAY_MAX_CLIENTS + 1];
+    uint8_t       owners[MODBUS_GATEWAY_MAX_CLIENTS + 1];
+    nfds_t        numFDs = 0;
+    fds[numFDs].fd       = _listenFD;
+    fds[numFDs].events   = POLLIN;
+    owners[numFDs++]     = 0xFF;
+    for (uint8_t i = 0; i < MODBUS_GATEWAY_MAX_CLIENTS; i++) {
+        if (_clients[i].fd < 0) { continue; }
+        fds[numFDs].fd     = _clients[i].fd;
+        fds[numFDs].events = POLLIN;
+        owners[numFDs++]   = i;
+    }
+    int ready = poll(fds, numFDs, waiting > 0 ? 0 : static_cast<int>(timeout));
+    if (ready > 0) {
+        for (nfds_t i = 0; i < numFDs; i++) {
+            if (fds[i].revents == 0) { continue; }
+            if (owners[i] == 0xFF) {
+                acceptClients();
+            } else {
+                readClient(owners[i]);
+            }
+        }
+    }
+
+    // Forward everything that is waiting now, taking the slaves in turn
+    waiting = 0;
+    for (uint8_t i = 0; i < MODBUS_GATEWAY_QUEUE_SIZE; i++) {
+        if (_queue[i].inUse) { waiting++; }
+    }
+    uint16_t forwarded = 0;
+    while (waiting-- > 0) {
+        int16_t next = nextRequest();
+        if (next < 0) { break; }
+        forward(static_cast<uint8_t>(next));
+        forwarded++;
+    }
+    return forwarded;
+}
+
+
+//----------------------------------------------------------------------------
+//                           TCP CLIENTS
+//----------------------------------------------------------------------------
+
+void modbusTcpGateway::acceptClients(void) {
+    for (;;) {
+        int fd = accept4(_listenFD, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) { return; }
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        uint8_t i = 0;
+        while (i < MODBUS_GATEWAY_MAX_CLIENTS && _clients[i].fd >= 0) { i++; }
+        if (i == MODBUS_GATEWAY_MAX_CLIENTS) {
+            // No room for another client
+            close(fd);
+            continue;
+        }
+        _clients[i].fd       = fd;
+        _clients[i].rxLength = 0;
+    }
+}
+
+void modbusTcpGateway::readClient(uint8_t index) {
+    gatewayClient& client = _clients[index];
+    ssize_t        got    = recv(client.fd, client.rxBuffer + client.rxLength,
+                                 MODBUS_TCP_FRAME_SIZE - client.rxLength, 0);
+    if (got == 0 || (got < 0 && errno != EAGAIN && errno != EINTR)) {
+        closeClient(index);
+        return;
+    }
+    if (got < 0) { return; }
+    client.rxLength += got;
+
+    // Take out every complete frame
+    // The MBAP header is {transaction (hi/lo), protocol (hi/lo), length (hi/lo), unit}
+    // and the length counts the unit ID and the PDU
+    while (client.rxLength >= 7) {
+        uint16_t length = (client.rxBuffer[4] << 8) | client.rxBuffer[5];
+        if (length < 2 || length > MODBUS_TCP_FRAME_SIZE - 6) {
+            // The framing is lost; there's no way to find the next request
+            closeClient(index);
+            return;
+        }
+        uint16_t frameLength = length + 6;
+        if (client.rxLength < frameLength) { break; }
+        queueRequest(index, client.rxBuffer, frameLength);
+        // The client may have been closed while answering
+        if (client.fd < 0) { return; }
+        client.rxLength -= frameLength;
+        memmove(client.rxBuffer, client.rxBuffer + frameLength, client.rxLength);
+    }
+}
+
+void modbusTcpGateway::closeClient(uint8_t index) {
+    if (_clients[index].fd >= 0) { close(_clients[index].fd); }
+    _clients[index].fd       = -1;
+    _clients[index].rxLength = 0;
+    // No one is left to answer
+    for (uint8_t i = 0; i < MODBUS_GATEWAY_QUEUE_SIZE; i++) {
+        if (_queue[i].inUse && _queue[i].client == index) { _queue[i].inUse = false; }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//                           THE REQUEST QUEUE
+//----------------------------------------------------------------------------
+
+void modbusTcpGateway::queueRequest(uint8_t index, const byte* frame,
+                                    uint16_t length) {
+    uint16_t transaction = (frame[0] << 8) | frame[1];
+    uint16_t protocol    = (frame[2] << 8) | frame[3];
+    // Only the modbus protocol (0) is defined
+    if (protocol != 0) { return; }
+    _requestCount++;
+
+    uint8_t i = 0;
+    while (i < MODBUS_GATEWAY_QUEUE_SIZE && _queue[i].inUse) { i++; }
+    if (i == MODBUS_GATEWAY_QUEUE_SIZE) {
+        respondException(index, transaction, frame[6], frame[7], SLAVE_DEVICE_BUSY);
+        return;
+    }
+    gatewayRequest& request = _queue[i];
+    request.inUse           = true;
+    request.client          = index;
+    request.transaction     = transaction;
+    request.sequence        = _nextSequence++;
+    request.unitID          = frame[6];
+    request.pduLength       = length - 7;
+    memcpy(request.pdu, frame + 7, request.pduLength);
+}
+
+int16_t modbusTcpGateway::nextRequest(void) {
+    // Serve the slaves in turn: the next slave after the last one served that has a
+    // request waiting, and that slave's oldest request
+    int16_t best         = -1;
+    uint8_t bestDistance = 0;
+    for (uint8_t i = 0; i < MODBUS_GATEWAY_QUEUE_SIZE; i++) {
+        if (!_queue[i].inUse) { continue; }
+        uint8_t distance = static_cast<uint8_t>(_queue[i].unitID - _lastUnit - 1);
+        if (best < 0 || distance < bestDistance ||
+            (distance == bestDistance &&
+             _queue[i].sequence - _queue[best].sequence > 0x80000000UL)) {
+            best         = i;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+void modbusTcpGateway::forward(uint8_t index) {
+    gatewayRequest& request = _queue[index];
+    byte            unitID  = request.unitID;
+    byte            fxn     = request.pdu[0];
+    _lastUnit               = unitID;
+
+    // The RTU frame is the unit ID, the PDU, and room for the CRC
+    uint16_t frameLength = request.pduLength + 3;
+    _rtuFrame[0]         = unitID;
+    memcpy(_rtuFrame + 1, request.pdu, request.pduLength);
+
+    // Try up to commandRetries times, stopping on an exception from the slave
+    modbusErrorCode error     = NO_RESPONSE;
+    uint16_t        bytesRead = 0;
+    uint8_t         tries     = 0;
+    do {
+        _forwardCount++;
+        bytesRead = _master.sendCommand(_rtuFrame, frameLength);
+        error     = _master.getLastError();
+        // A good response must be to the same function
+        if (error == NO_ERROR && unitID != 0 &&
+            (bytesRead < 4 || (modbusMaster::responseBuffer[1] & 0x7F) != fxn)) {
+            error = BAD_CRC;
+        }
+        tries++;
+    } while (static_cast<int8_t>(error) >= 0x0C && tries < _master.getCommandRetries());
+
+    // Broadcasts never get an answer
+    if (unitID == 0) {
+        request.inUse = false;
+        return;
+    }
+
+    // Answer this request and every identical read waiting with it
+    bool isRead = fxn >= 0x01 && fxn <= 0x04;
+    for (uint8_t i = 0; i < MODBUS_GATEWAY_QUEUE_SIZE; i++) {
+        gatewayRequest& other = _queue[i];
+        if (!other.inUse) { continue; }
+        if (i != index &&
+            (!isRead || other.unitID != unitID ||
+             other.pduLength != request.pduLength ||
+             memcmp(other.pdu, request.pdu, request.pduLength) != 0)) {
+            continue;
+        }
+        if (i != index) { _coalescedCount++; }
+        if (error == NO_ERROR) {
+            // Leave out the unit ID and the CRC
+            respond(other.client, other.transaction, unitID,
+                    modbusMaster::responseBuffer + 1, bytesRead - 3);
+        } else if (static_cast<int8_t>(error) < 0x0C) {
+            respondException(other.client, other.transaction, unitID, fxn, error);
+        } else {
+            respondException(other.client, other.transaction, unitID, fxn,
+                             GATEWAY_TARGET_DEVICE_FAILED_TO_RESPOND);
+        }
+        other.inUse = false;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//                           RESPONSES
+//----------------------------------------------------------------------------
+
+void modbusTcpGateway::respond(uint8_t client, uint16_t transaction, byte unitID,
+                               const byte* pdu, uint8_t pduLength) {
+    if (_clients[client].fd < 0) { return; }
+    byte     frame[MODBUS_TCP_FRAME_SIZE];
+    uint16_t length = pduLength + 1;
+    frame[0]        = transaction >> 8;
+    frame[1]        = transaction & 0xFF;
+    frame[2]        = 0;
+    frame[3]        = 0;
+    frame[4]        = length >> 8;
+    frame[5]        = length & 0xFF;
+    frame[6]        = unitID;
+    memcpy(frame + 7, pdu, pduLength);
+    ssize_t sent = send(_clients[client].fd, frame, pduLength + 7, MSG_NOSIGNAL);
+    if (sent != pduLength + 7) { closeClient(client); }
+}
+
+void modbusTcpGateway::respondException(uint8_t client, uint16_t transaction,
+                                        byte unitID, byte function,
+                                        modbusErrorCode error) {
+    byte pdu[2] = {static_cast<byte>(function | 0x80), static_cast<byte>(error)};
+    respond(client, transaction, unitID, pdu, 2);
+}
+
+#endif  // MODBUSMASTER_HAS_TCP_GATEWAY
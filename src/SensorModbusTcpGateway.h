@@ -0,0 +1,228 @@
+/**
+ * @file SensorModbusTcpGateway.h
+ * @copyright Stroud Water Research Center
+ * Part of the EnviroDIY SensorModbusMaster library for Arduino.
+ * @license This library is published under the BSD-3 license.
+ *
+ * @brief Contains the modbusTcpGateway class declarations.
+ *
+ * The gateway exposes the RTU slaves on a modbusMaster's bus to Modbus TCP clients.  It
+ * uses BSD sockets and is only compiled on Linux; on other platforms this file is
+ * empty.
+ */
+
+#ifndef SensorModbusTcpGateway_h
+#define SensorModbusTcpGateway_h
+
+#include "SensorModbusMaster.h"
+
+#if defined(__linux__)
+/**
+ * @brief Defined if the modbusTcpGateway is available on this platform
+ */
+#define MODBUSMASTER_HAS_TCP_GATEWAY
+
+/**
+ * @brief The most TCP clients a gateway will serve at once
+ */
+#define MODBUS_GATEWAY_MAX_CLIENTS 8
+/**
+ * @brief The most requests a gateway will hold waiting for the RTU bus
+ *
+ * Requests that arrive while the queue is full are answered with a #SLAVE_DEVICE_BUSY
+ * exception.
+ */
+#define MODBUS_GATEWAY_QUEUE_SIZE 16
+/**
+ * @brief The largest Modbus TCP frame: a 7 byte MBAP header and a 253 byte PDU
+ */
+#define MODBUS_TCP_FRAME_SIZE 260
+
+/**
+ * @brief A Modbus TCP to RTU gateway built on a modbusMaster.
+ *
+ * The gateway listens for Modbus TCP clients, forwards each request to the RTU slave
+ * named by its unit ID, and sends the answer back with the client's transaction ID.
+ *
+ * - Requests are queued per slave and the slaves are served in turn, so one slow
+ * slave does not starve the others.
+ * - Identical reads (same unit, function, and range) waiting at the same time are
+ * sent to the bus once and the answer is copied to every client that asked.
+ * - A slave that does not answer gets a #GATEWAY_TARGET_DEVICE_FAILED_TO_RESPOND
+ * exception; requests with unit ID 0 are broadcast and get no answer.
+ *
+ * Everything runs in whichever thread calls process(); the modbusMaster must not be
+ * used anywhere else while the gateway is running.
+ */
+class modbusTcpGateway {
+ public:
+    /**
+     * @brief Construct a new modbus Tcp Gateway object
+     *
+     * @param master The modbusMaster connected to the RTU bus.  It must already have
+     * begun.
+     */
+    explicit modbusTcpGateway(modbusMaster& master);
+    /**
+     * @brief Destroy the modbus Tcp Gateway object, closing all connections
+     */
+    ~modbusTcpGateway();
+
+    /**
+     * @brief Start listening for clients
+     *
+     * @param port The TCP port to listen on; Modbus TCP uses 502. Optional with a
+     * default of 502.
+     * @param bindAddress The IPv4 address to listen on; nullptr for all addresses.
+     * Optional with a default of nullptr.
+     * @return True if the gateway is listening.
+     */
+    bool begin(uint16_t port = 502, const char* bindAddress = nullptr);
+    /**
+     * @brief Stop listening and close all connections
+     */
+    void end();
+    /**
+     * @brief Get the port the gateway is listening on
+     *
+     * This is useful after beginning on port 0, which picks a free port.
+     *
+     * @return The port number; 0 if not listening.
+     */
+    uint16_t getPort() const;
+
+    /**
+     * @brief Accept clients, read their requests, and forward one round of requests
+     * to the bus
+     *
+     * Call this in a loop.  When there is nothing to do, it sleeps in poll() until a
+     * client sends something or the timeout passes.
+     *
+     * @param timeout The longest time to wait for network activity (in ms). Optional
+     * with a default of 100.
+     * @return The number of requests forwarded to the bus.
+     */
+    uint16_t process(uint32_t timeout = 100);
+
+    /**
+     * @brief Get the number of requests received from clients
+     *
+     * @return The number of requests received.
+     */
+    uint32_t getRequestCount() const {
+        return _requestCount;
+    }
+    /**
+     * @brief Get the number of requests sent to the RTU bus
+     *
+     * @return The number of requests forwarded.
+     */
+    uint32_t getForwardCount() const {
+        return _forwardCount;
+    }
+    /**
+     * @brief Get the number of requests answered from another client's identical read
+     * instead of being sent to the bus
+     *
+     * @return The number of coalesced requests.
+     */
+    uint32_t getCoalescedCount() const {
+        return _coalescedCount;
+    }
+
+ private:
+    /**
+     * @brief A connected TCP client
+     */
+    typedef struct gatewayClient {
+        int      fd;  ///< The socket; -1 if this slot is free
+        uint16_t rxLength;  ///< The number of bytes in the receive buffer
+        byte     rxBuffer[MODBUS_TCP_FRAME_SIZE];  ///< The partly received frame
+    } gatewayClient;
+    /**
+     * @brief A request waiting for the RTU bus
+     */
+    typedef struct gatewayRequest {
+        bool     inUse;        ///< True if this slot holds a request
+        uint8_t  client;       ///< The index of the client that sent it
+        uint16_t transaction;  ///< The client's transaction ID
+        uint32_t sequence;     ///< The order the request arrived in
+        byte     unitID;       ///< The RTU slave to send it to
+        uint8_t  pduLength;    ///< The length of the PDU
+        byte     pdu[MODBUS_TCP_FRAME_SIZE - 7];  ///< The function code and data
+    } gatewayRequest;
+
+    /**
+     * @brief Accept any waiting clients
+     */
+    void acceptClients(void);
+    /**
+     * @brief Read from a client and queue any complete requests
+     *
+     * @param index The index of the client
+     */
+    void readClient(uint8_t index);
+    /**
+     * @brief Close a client's connection and drop its waiting requests
+     *
+     * @param index The index of the client
+     */
+    void closeClient(uint8_t index);
+    /**
+     * @brief Queue a complete request from a client
+     *
+     * @param index The index of the client
+     * @param frame The Modbus TCP frame
+     * @param length The length of the frame
+     */
+    void queueRequest(uint8_t index, const byte* frame, uint16_t length);
+    /**
+     * @brief Find the oldest waiting request for the next slave in turn
+     *
+     * @return The index of the request; -1 if none are waiting.
+     */
+    int16_t nextRequest(void);
+    /**
+     * @brief Send a request to the RTU bus and answer it, and any identical reads
+     *
+     * @param index The index of the request
+     */
+    void forward(uint8_t index);
+    /**
+     * @brief Send a response to a client
+     *
+     * @param client The index of the client
+     * @param transaction The client's transaction ID
+     * @param unitID The unit ID of the request
+     * @param pdu The function code and data of the response
+     * @param pduLength The length of the PDU
+     */
+    void respond(uint8_t client, uint16_t transaction, byte unitID, const byte* pdu,
+                 uint8_t pduLength);
+    /**
+     * @brief Send an exception response to a client
+     *
+     * @param client The index of the client
+     * @param transaction The client's transaction ID
+     * @param unitID The unit ID of the request
+     * @param function The function code of the request
+     * @param error The exception code
+     */
+    void respondException(uint8_t client, uint16_t transaction, byte unitID,
+                          byte function, modbusErrorCode error);
+
+    modbusMaster&  _master;        ///< The master connected to the RTU bus
+    int            _listenFD;      ///< The listening socket; -1 if not listening
+    uint32_t       _nextSequence;  ///< The sequence number of the next request
+    byte           _lastUnit;      ///< The slave served most recently
+    uint32_t       _requestCount;  ///< Requests received
+    uint32_t       _forwardCount;  ///< Requests sent to the bus
+    uint32_t       _coalescedCount;  ///< Requests answered by another identical read
+    gatewayClient  _clients[MODBUS_GATEWAY_MAX_CLIENTS];  ///< The connected clients
+    gatewayRequest _queue[MODBUS_GATEWAY_QUEUE_SIZE];     ///< The waiting requests
+    byte           _rtuFrame[MODBUS_TCP_FRAME_SIZE];      ///< The RTU request frame
+};
+
+#endif  // __linux__
+
+#endif